@@ -0,0 +1,42 @@
+
+/*
+  Prometheus metrics endpoint
+  library metrics (heap, capture drops, pingAlive) are included,
+  scrape with: curl http://esp-ip-address:9100/metrics
+
+  released to the public domain
+*/
+
+#include <ESP8266WiFi.h>
+#include <Metrics.h>
+
+#define SSID "ssid"
+#define PSK "psk"
+
+metric loops (METRIC_COUNTER, F("sketch_loops_total"), F("loop() calls"));
+
+static const int32_t loop_us_bounds [] = { 10, 100, 1000, 10000, 100000 };
+metric_histogram<5> loop_us (F("sketch_loop_us"), F("loop() duration"), loop_us_bounds);
+
+void setup() {
+  Serial.begin(115200);
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(SSID, PSK);
+  while (WiFi.status() != WL_CONNECTED) {
+    Serial.print('.');
+    delay(500);
+  }
+  Serial.println(WiFi.localIP());
+
+  metrics_setup();
+}
+
+void loop() {
+  unsigned long start = micros();
+
+  metrics_loop();
+  // put your main code here, to run repeatedly:
+
+  loops.inc();
+  loop_us.observe(micros() - start);
+}
@@ -9,12 +9,21 @@
 
 void dump (int netif_idx, const char* data, size_t len, int out, int success) {
   (void)success;
+
+  // optional: collapse repeated lines (ARP, SSDP, mDNS chatter...)
+  // if (!netDumpSummary(Serial, data, len, netif_idx, out)) return;
+
   Serial.print(out ? F("out ") : F(" in "));
   Serial.printf("%d ", netif_idx);
 
+  // optional: show real mac addresses (placeholders are given for output frames)
+  // if (out) netDumpMacsForOutput(Serial, data, len, netif_idx); else { netDumpArpLearn(data, len, netif_idx); netDumpMacs(Serial, data); }
+
   // optional filter example: if (netDump_is_ARP(data))
+  // or with NetDumpFilter.h: if (netdump_filter::match(netdump_filter::Arp, data, len))
   {
     netDump(Serial, data, len);
+    //netDumpCbor(Serial, data, len, netif_idx, out, micros()); // binary, for tools/netdump_cbor.py
     //netDumpHex(Serial, data, len);
   }
 }
@@ -27,5 +36,6 @@ void setup(void) {
 }
 
 void loop(void) {
+  // netDumpSummaryFlush(Serial);
   // put your main code here, to run repeatedly:
 }
@@ -0,0 +1,41 @@
+/*
+  replay captured traffic into the network stack (load generator)
+  capture with full frames from another (or this) esp:
+     nc esp-ip-address 2 | tcpdump -w traffic.pcap    (with tcpdump_setup(2, 1536))
+  then replay it here:
+     nc esp-ip-address 3 < traffic.pcap
+
+  released to the public domain
+*/
+
+#include <ESP8266WiFi.h>
+#include <NetDump.h>
+
+#define SSID "ssid"
+#define PSK "psk"
+
+void setup() {
+  Serial.begin(115200);
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(SSID, PSK);
+  while (WiFi.status() != WL_CONNECTED) {
+    Serial.print('.');
+    delay(500);
+  }
+  Serial.println(WiFi.localIP());
+
+  // ip address of the esp the traffic was captured on
+  netDumpReplayDevice((uint32_t)IPAddress(192, 168, 1, 50));
+  // original timing (speed 1), or e.g. 4 times faster, or 0 for no wait
+  netDumpReplaySetup(3, 1);
+}
+
+void loop() {
+  netDumpReplayLoop();
+
+  static unsigned long last = 0;
+  if (millis() - last > 1000) {
+    last = millis();
+    netDumpReplayPrint(Serial);
+  }
+}
@@ -14,6 +14,11 @@ void setup() {
   // setup WiFi
   // now tcpdump server can be initialized
   tcpdump_setup();
+  // or, without tcp (nothing ever waits, lost datagrams are reported by the receiver):
+  //     tools/netdump-udp-rx | tcpdump -r - [<options>] [<pcap-filter>]
+  //tcpdump_udp_setup(IPAddress(192, 168, 1, 10));
+  // optionally only capture the first 10 packets of each tcp/udp flow (and their FIN/RST)
+  //tcpdump_flow_budget(10);
 }
 
 void loop() {
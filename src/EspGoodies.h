@@ -2,15 +2,101 @@
 #ifndef __ESPGOODIES_H
 #define __ESPGOODIES_H
 
+#include <time.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "utility/TZ.h"
+#include "utility/trace.h"
 
 class __FlashStringHelper;
 
 void configTZ (const __FlashStringHelper* TZ); // use only TZ-entries (FPSTR("..."))
 
+// runtime lookup by zone name ("Europe/Paris"), binary search in flash
+const __FlashStringHelper* TZByName (const char* name); // nullptr if unknown
+bool configTZByName (const char* name);
+
+// utc to local time from the rule given to configTZ(), without newlib's localtime()
+// DST transitions are cached, use gmtime_r() on the result to get a struct tm
+time_t TZToLocal (time_t utc);
+void   TZToLocal (const time_t* utc, time_t* local, size_t n);
+
+// wifi_off() saves channel, BSSID and lease in RTC memory,
+// next wifi_on() connects directly with them (no scan, no DHCP),
+// and falls back to the full path when it fails
 void wifi_on();
 void wifi_off();
+extern uint32_t wifi_on_ms;      // last wifi_on() to connected time, 0 while connecting
+extern bool     wifi_on_resumed; // it was with the saved state
+// radio scheduler, owns wifi_on() / wifi_off():
+// messages are queued with a deadline, the radio is woken up just in time
+// for the earliest one (estimated from wifi_on_ms), all queued messages
+// are sent in one batch, and the radio is switched off again
+// call radio_loop() from loop()
+
+#define RADIO_QUEUE         16
+#define RADIO_WAKE_INITIAL  5000    // ms, first wake-up estimate
+#define RADIO_WAKE_MARGIN   500     // ms
+#define RADIO_LINGER        200     // ms kept on after sending (acks)
+
+typedef void (*radio_send_f) (void* arg, bool connected); // connected=false: could not connect
+
+bool radio_enqueue (uint32_t within_ms, radio_send_f send, void* arg = nullptr); // false: queue full
+void radio_loop ();
+bool radio_is_on ();
+
+struct radio_stats
+{
+    uint32_t wakeups;
+    uint32_t messages;
+    uint32_t failed;
+    uint32_t late;      // sent after their deadline
+    uint32_t on_ms;     // total radio-on time (on_ms / messages: cost of a message)
+};
+extern struct radio_stats radio_stats;
+
 void uart_set_loopback (int uart_nr, bool enable);
+
+// serial loopback benchmark at rising baud rates (UART_BENCH_BAUDS)
+// the port is unusable meanwhile (and its TX pin shows garbage)
+// returns the index of the fastest reliable result, or -1
+class HardwareSerial;
+class Print;
+struct uart_bench_result;
+int  uart_loopback_bench (HardwareSerial& serial, int uart_nr, uart_bench_result* results, size_t count);
+void uart_bench_print (Print& out, const uart_bench_result* results, size_t count, int best);
 int  hard_reset_needed (void);
 
+// boot profiler: time of the first occurrence of each phase since cpu reset,
+// from the cycle counter, for the last BOOT_PROFILE_BOOTS boots kept in RTC memory
+// (survives reset and deep sleep, not power loss)
+
+#define BOOT_PROFILE_BOOTS 4
+
+enum boot_phase
+{
+    BOOT_RESET,     // always 0
+    BOOT_SETUP,     // call boot_mark(BOOT_SETUP) first thing in setup()
+    BOOT_WIFI,      // associated
+    BOOT_DHCP,      // got IP
+    BOOT_NTP,       // time synced
+    BOOT_PUBLISH,   // first application message sent
+    BOOT_USER1,
+    BOOT_USER2,
+    BOOT_PHASES
+};
+
+struct boot_record
+{
+    uint32_t us[BOOT_PHASES];   // 0: phase not reached
+    uint32_t reason;            // rst_info.reason
+};
+
+void   boot_mark (boot_phase phase);
+size_t boot_profile_export (boot_record* records, size_t max); // latest first
+void   boot_profile_print (Print& out);                        // with averages across boots
+
+// writes the trace ring in binary form (to a file, a tcp client...) for tools/trace2json
+void trace_dump (Print& out);
+
 #endif // __ESPGOODIES
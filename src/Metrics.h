@@ -0,0 +1,84 @@
+/*
+ Metrics - counters, gauges and histograms in Prometheus text format
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __METRICS_H
+#define __METRICS_H
+
+#include <Print.h>
+
+// metrics are declared as global variables, they register themselves
+// (no heap): names and help strings must be flash strings F("...")
+//
+//     metric requests (METRIC_COUNTER, F("http_requests_total"), F("served requests"));
+//     requests.inc();
+//
+// a metric can also be read from a function when rendered:
+//
+//     int32_t heap () { return ESP.getFreeHeap(); }
+//     metric free_heap (METRIC_GAUGE, F("heap_free_bytes"), F("free heap"), heap);
+
+enum metric_type
+{
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM,
+};
+
+struct metric
+{
+    metric (metric_type type, const __FlashStringHelper* name, const __FlashStringHelper* help, int32_t (*read) () = nullptr);
+    metric (const __FlashStringHelper* name, const __FlashStringHelper* help, const int32_t* bounds, uint32_t* buckets, uint8_t nbounds);
+
+    void inc     (int32_t n = 1) { value += n; }
+    void set     (int32_t v)     { value = v; }
+    void observe (int32_t v);   // histogram
+
+    metric* next;
+    const __FlashStringHelper* name;
+    const __FlashStringHelper* help;
+    metric_type type;
+    int32_t value;              // counters are rendered unsigned
+    int32_t (*read) ();
+
+    // histogram
+    const int32_t* bounds;      // upper bounds, ascending
+    uint32_t* buckets;          // nbounds + 1 (+Inf), not cumulative
+    uint8_t nbounds;
+    int64_t sum;
+};
+
+// histogram with its bucket storage
+// static const int32_t rtt_ms [] = { 5, 10, 20, 50, 100, 200, 500 };
+// metric_histogram<7> rtt (F("rtt_ms"), F("round-trip time"), rtt_ms);
+template <uint8_t N>
+struct metric_histogram: public metric
+{
+    metric_histogram (const __FlashStringHelper* name, const __FlashStringHelper* help, const int32_t (&bounds) [N]):
+        metric(name, help, bounds, counts, N) { }
+    uint32_t counts [N + 1];
+};
+
+// renders all metrics, streamed on out
+void metrics_render (Print& out);
+
+// http server, answers any request with metrics_render()
+// call metrics_setup() in your setup(), metrics_loop() in your loop()
+bool metrics_setup (uint16_t port = 9100);
+void metrics_loop ();
+
+#endif // __METRICS_H
@@ -62,15 +62,129 @@ inline uint16_t netDump_getTcpHdrLen (const char* ethdata) { return (ntoh16(ethd
 inline uint16_t netDump_getTcpWindow (const char* ethdata) { return ntoh16(ethdata + ETH_HDR_LEN + netDump_getIpHdrLen(ethdata) + 14); }
 inline uint16_t netDump_getTcpUsrLen (const char* ethdata) { return netDump_getIpUsrLen(ethdata) - netDump_getTcpHdrLen(ethdata); }
 
+// checksums, verified when the ip packet is entirely captured (and not fragmented)
+// filter example: if (netDump_badSums(data, len)) netDump(Serial, data, len);
+// bad ones are also shown by netDump()
+
+#define NETDUMP_SUM_BAD_IP  1
+#define NETDUMP_SUM_BAD_L4  2   // tcp, udp, icmp
+
+int  netDump_badSums     (const char* ethdata, size_t size);
+void netDumpChksumBench  (Print& out);  // utility/chksum.c against lwIP's inet_chksum()
+
+// compile-time filters (Ipv4 && Tcp && DstPort<443>): see NetDumpFilter.h
+void netDumpFilterBench  (Print& out);  // NetDumpFilter.h against the same test written by hand
+
 void netDumpIPv4 (Print& out, const char* ethdata);
 void netDumpMac  (Print& out, const char* mac);
 void netDumpMacs (Print& out, const char* mac);
 
+// mac addresses of output frames:
+// phy_capture gives placeholders instead of the real source and destination macs
+// netDumpMacsResolve() writes the real ones (dst then src, 12 bytes) into macs
+// (which may be ethdata itself when writable) and returns false when the
+// destination is not known yet, incoming frames are copied as-is and their
+// arp content is learned (call it for every captured frame, in and out)
+// netDumpMacsForOutput() prints them as "src>dst" like netDumpMacs()
+
+#define NETDUMP_ARP_CACHE   16      // ip->mac entries, power of 2
+#define NETDUMP_ARP_MAXAGE  300000  // ms, a mac no longer in etharp is still used for (lwIP's default ARP_MAXAGE)
+
+bool netDumpMacsResolve   (char* macs, const char* ethdata, size_t size, int netif_idx, int out);
+void netDumpMacsForOutput (Print& out, const char* ethdata, size_t size, int netif_idx);
+void netDumpArpLearn      (const char* ethdata, size_t size, int netif_idx);
+void netDumpArpFlush      ();
+
 // main dump functions
 
 void netDump    (Print& out, const char* ethdata, size_t size);
 void netDumpHex (Print& out, const char* data, size_t size, bool show_hex = true, bool show_ascii = true, size_t per_line = 16);
 
+// machine output: one cbor (rfc8949) map per packet, with integer keys
+// fields are present when known (negative netif_idx/out_dir or 0 time_us are omitted)
+// and not redundant (no size when the ip packet is complete, no ethtype for ipv4/arp)
+// payload: up to that many captured bytes of tcp/udp/icmp payload, macs: add mac addresses
+// decode with tools/netdump_cbor.py (keep keys in sync)
+
+#define NETDUMP_CBOR_TIME       0   // us
+#define NETDUMP_CBOR_OUT        1   // 0: in, 1: out
+#define NETDUMP_CBOR_NETIF      2
+#define NETDUMP_CBOR_SIZE       3   // captured bytes, when snapped or not ipv4
+#define NETDUMP_CBOR_DST_MAC    4   // bytes
+#define NETDUMP_CBOR_SRC_MAC    5   // bytes
+#define NETDUMP_CBOR_ETHTYPE    6   // not ipv4 nor arp
+#define NETDUMP_CBOR_SRC_IP     7   // bytes (ipv4, arp sender)
+#define NETDUMP_CBOR_DST_IP     8   // bytes (ipv4, arp target)
+#define NETDUMP_CBOR_PROTO      9
+#define NETDUMP_CBOR_LEN        10  // ip total length
+#define NETDUMP_CBOR_SRC_PORT   11
+#define NETDUMP_CBOR_DST_PORT   12
+#define NETDUMP_CBOR_FLAGS      13  // tcp
+#define NETDUMP_CBOR_SEQ        14
+#define NETDUMP_CBOR_ACK        15
+#define NETDUMP_CBOR_WINDOW     16
+#define NETDUMP_CBOR_USR_LEN    17  // tcp/udp payload length
+#define NETDUMP_CBOR_ICMP_TYPE  18
+#define NETDUMP_CBOR_ARP_OP     19
+#define NETDUMP_CBOR_ARP_MAC    20  // bytes, arp reply
+#define NETDUMP_CBOR_BAD_SUMS   21  // NETDUMP_SUM_BAD_*
+#define NETDUMP_CBOR_PAYLOAD    22  // bytes
+
+void netDumpCbor (Print& out, const char* ethdata, size_t size, int netif_idx = -1, int out_dir = -1, uint64_t time_us = 0, size_t payload = 0, bool macs = false);
+
+// summarizing mode:
+// identical lines (direction, netif, protocol, addresses, ports, arp/icmp type or tcp flags)
+// within NETDUMP_SUMMARY_WINDOW ms of their first print are only counted,
+// then reported as "last message repeated N times"
+// netDumpSummary() returns false when the packet should not be printed
+// call netDumpSummaryFlush() from loop() to report pending counts
+
+#define NETDUMP_SUMMARY_WINDOW  10000   // ms
+#define NETDUMP_SUMMARY_LRU     8       // lines remembered
+
+bool netDumpSummary      (Print& out, const char* ethdata, size_t size, int netif_idx, int out_dir);
+void netDumpSummaryFlush (Print& out);
+
+// dns and dhcp transaction latency tracker:
+// queries are matched to answers by dns id, dhcp DISCOVER/OFFER and REQUEST/ACK by xid,
+// with fixed tables, per server: latency (min/avg/max, log2 histogram), retries, timeouts
+// netDumpLatency() is phy_capture compatible: assign it, or call it from your own capture function
+
+#define NETDUMP_LATENCY_SERVERS 4       // (server, kind) entries
+#define NETDUMP_LATENCY_PENDING 8       // requests waiting for an answer
+#define NETDUMP_LATENCY_TIMEOUT 5000    // ms
+#define NETDUMP_LATENCY_HIST    12      // log2(ms) buckets
+
+#define NETDUMP_LATENCY_DNS             0
+#define NETDUMP_LATENCY_DHCP_DISCOVER   1   // DISCOVER -> OFFER, one entry for 255.255.255.255 (any server)
+#define NETDUMP_LATENCY_DHCP_REQUEST    2   // REQUEST -> ACK/NAK
+
+struct netdump_latency_server
+{
+    bool     used;
+    uint8_t  kind;
+    uint32_t ip;                            // network order, 255.255.255.255 for DISCOVER
+    uint32_t answered;
+    uint32_t retries;
+    uint32_t timeouts;
+    uint32_t min_ms;
+    uint32_t max_ms;
+    uint32_t sum_ms;
+    uint16_t hist[NETDUMP_LATENCY_HIST];    // [i]: 2^i <= ms < 2^(i+1), [0] includes 0, last one open-ended
+};
+
+struct netdump_latency
+{
+    netdump_latency_server servers[NETDUMP_LATENCY_SERVERS];
+    uint32_t unmatched;                     // answers without a request
+    uint32_t overflow;                      // tables full
+};
+
+void netDumpLatency         (int netif_idx, const char* ethdata, size_t size, int out, int success);
+void netDumpLatencySnapshot (netdump_latency* snapshot);
+void netDumpLatencyReset    ();
+void netDumpLatencyPrint    (Print& out);
+
 // tcpdump server:
 // call tcpdump_setup() in your setup()
 // call tcpdump_loop() in your loop()
@@ -81,4 +195,96 @@ bool tcpdump_setup (uint16_t port = 2, size_t snap = 96, bool fast = true);
 void tcpdump_loop ();
 extern size_t tcpdump_err;
 
+// capture memory: allocated when a client connects (or at tcpdump_udp_setup()),
+// released on disconnect, up to max bytes while leaving heap_reserve bytes free,
+// shrunk when the heap gets lower, grown back later
+
+#define TCPDUMP_BUFFER_MAX      4096
+#define TCPDUMP_HEAP_RESERVE    8192
+
+void   tcpdump_memory      (size_t max = TCPDUMP_BUFFER_MAX, size_t heap_reserve = TCPDUMP_HEAP_RESERVE);
+size_t tcpdump_buffer_size ();  // 0 when not capturing
+
+// per-flow capture budget (tcp and udp):
+// only the first packets / bytes of each flow are captured, plus tcp FIN and RST
+// flows unseen for TCPDUMP_FLOW_IDLE ms are forgotten
+// 0 means no limit, both 0 disables (default)
+
+#define TCPDUMP_FLOWS       32      // flows tracked
+#define TCPDUMP_FLOW_PROBES 4
+#define TCPDUMP_FLOW_IDLE   30000   // ms
+
+void tcpdump_flow_budget (uint16_t packets, uint32_t bytes = 0);
+extern size_t tcpdump_flow_skipped;
+
+// connectionless export, instead of tcpdump_setup():
+// captured records are packed into udp datagrams sent to a collector
+// from tcpdump_loop(), without ever waiting (lost datagrams show up as
+// sequence gaps on the receiver side), on the collector run:
+//     tools/netdump-udp-rx [port] | tcpdump -r - [<options>] [<pcap-filter>]
+// datagram: "NDU1", seq (u32), snaplen (u16), count (u16), then count pcap-savefile(5) records
+// (little endian)
+
+#define TCPDUMP_UDP_PORT 5002
+
+class IPAddress;
+bool tcpdump_udp_setup (const IPAddress& collector, uint16_t port = TCPDUMP_UDP_PORT, size_t snap = 96);
+
+// rpcap server, for wireshark's remote interfaces (null authentication):
+//     rpcap://esp-ip-address:2002/esp8266
+// capture filters then sampling set in wireshark are applied here,
+// only matching packets (up to the requested snaplen) are sent
+// one capture at a time, not together with the tcpdump server
+// filters are limited to (1024 - 8) / 8 = 127 instructions
+// call rpcap_setup() in setup() and rpcap_loop() in loop()
+
+#define RPCAP_PORT      2002
+#define RPCAP_DATA_PORT 2003
+
+struct rpcap_stats
+{
+    uint32_t received;  // seen in the requested directions
+    uint32_t filtered;  // rejected by the filter
+    uint32_t dropped;   // no room
+    uint32_t captured;  // sent
+};
+
+bool rpcap_setup (uint16_t port = RPCAP_PORT, uint16_t data_port = RPCAP_DATA_PORT);
+void rpcap_loop ();
+extern rpcap_stats rpcap;
+
+// pcap replay, the counterpart of phy_capture:
+// frames from a pcap-savefile(5) stream are injected in the netif input path
+// as if received, with their original timing divided by speed (0: no wait)
+// the captured device's ip must be given first with netDumpReplayDevice()
+// (setup and replay fail otherwise): frames and arp it sent are skipped,
+// ipv4 and arp frames to it are rewritten with our mac and ip (checksums
+// updated), other ethernet types and snapped records are not replayed
+// (capture them with tcpdump_setup(port, 1536))
+// - from a tcp client:       netDumpReplaySetup(), then: nc esp-ip-address 3 < file.pcap
+// - from a file (LittleFS):  netDumpReplay(&file)
+// call netDumpReplayLoop() from loop()
+
+#define NETDUMP_REPLAY_BURST    8   // records injected per netDumpReplayLoop() call at most
+
+struct netdump_replay_stats
+{
+    uint32_t packets;       // injected
+    uint32_t bytes;
+    uint32_t drops;         // no memory or refused by the netif
+    uint32_t skipped;       // sent by the captured device, not ipv4 nor arp
+    uint32_t truncated;     // snapped by the capture
+    uint32_t heap_min;
+    uint32_t duration_ms;   // when done
+    bool done;
+};
+
+class Stream;
+bool netDumpReplay       (Stream* from, float speed = 1.0, int netif_idx = 0);
+bool netDumpReplaySetup  (uint16_t port = 3, float speed = 1.0, int netif_idx = 0);
+void netDumpReplayDevice (uint32_t captured_ip);    // network order, e.g. (uint32_t)IPAddress(10, 0, 0, 2)
+void netDumpReplayLoop   ();
+void netDumpReplayPrint  (Print& out);
+extern netdump_replay_stats netdump_replay;
+
 #endif // __NETDUMP_H
@@ -0,0 +1,230 @@
+/*
+ NetDump filters - compile-time packet predicates
+
+ Copyright (c) 2018 David Gauchard. All rights reserved.
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef __NETDUMP_FILTER_H
+#define __NETDUMP_FILTER_H
+
+// fixed filters built at compile time from the NetDump.h accessors (c++14),
+// no runtime parsing, each test checks the captured size before reading:
+//
+//     #include <NetDumpFilter.h>
+//     using namespace netdump_filter;
+//
+//     constexpr auto https = (Ipv4 && Tcp && DstPort<443>) || Arp;
+//
+//     if (match(https, data, len)) ...                 // in a capture function
+//     phy_capture = gate<decltype(https), dump>;       // or in front of one
+//
+// ip tests are ipv4 only, port tests are true for tcp and udp
+// (first fragment only), && || ! have their usual meaning and precedence
+// see netDumpFilterBench() for the cost against a hand-written test,
+// tools/netdump-filter-bench for the same on a host
+
+#include <NetDump.h>
+#include <type_traits>
+
+// a composed filter is flattened into its caller (also with -Os), so that
+// what a test has validated is known to the next ones
+#define NETDUMP_FILTER_INLINE inline __attribute__((always_inline))
+
+namespace netdump_filter
+{
+
+struct filter { };
+
+template <typename F>
+using if_filter = typename std::enable_if<std::is_base_of<filter, F>::value>::type;
+
+// the frame and what the tests already run on it have validated: a test
+// relying on a lower layer (ports on ipv4) reuses it instead of checking
+// again, the compiler keeps it in registers
+struct layers
+{
+    const char* d;
+    size_t   size;
+    uint16_t l4;        // transport header offset, 0 until ipv4 is validated
+    bool     ports;     // tcp or udp, first fragment, ports captured
+};
+
+// combinators
+
+template <typename L, typename R>
+struct both: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f) { return L::test(f) && R::test(f); }
+};
+
+template <typename L, typename R>
+struct either: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f) { return L::test(f) || R::test(f); }
+};
+
+template <typename F>
+struct negate: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f) { return !F::test(f); }
+};
+
+template <typename L, typename R, typename = if_filter<L>, typename = if_filter<R>>
+constexpr both<L, R> operator&& (L, R) { return both<L, R>(); }
+
+template <typename L, typename R, typename = if_filter<L>, typename = if_filter<R>>
+constexpr either<L, R> operator|| (L, R) { return either<L, R>(); }
+
+template <typename F, typename = if_filter<F>>
+constexpr negate<F> operator! (F) { return negate<F>(); }
+
+// tests
+
+template <uint16_t T>
+struct ethtype: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f) { return f.size >= ETH_HDR_LEN && netDump_ethtype(f.d) == T; }
+};
+
+struct ipv4: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f)
+    {
+        if (f.l4)
+            return true;
+        if (f.size < ETH_HDR_LEN + 20 || !netDump_is_IPv4(f.d))
+            return false;
+        f.l4 = ETH_HDR_LEN + netDump_getIpHdrLen(f.d);
+        return true;
+    }
+};
+
+struct arp: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f) { return f.size >= ETH_HDR_LEN + 28 && netDump_is_ARP(f.d); }
+};
+
+template <uint8_t OP>
+struct arp_op: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f) { return arp::test(f) && netDump_getARPType(f.d) == OP; }
+};
+
+template <uint8_t P>
+struct ip_proto: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f) { return ipv4::test(f) && netDump_getIpType(f.d) == P; }
+};
+
+// tcp or udp, first fragment, ports captured
+struct l4: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f)
+    {
+        if (f.ports)
+            return true;
+        return f.ports = ipv4::test(f)
+            && (netDump_is_TCP(f.d) || netDump_is_UDP(f.d))
+            && !(ntoh16(f.d + ETH_HDR_LEN + 6) & 0x1fff)
+            && f.size >= f.l4 + 4u;
+    }
+};
+
+template <uint16_t P>
+struct src_port: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f) { return l4::test(f) && ntoh16(f.d + f.l4) == P; }
+};
+
+template <uint16_t P>
+struct dst_port: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f) { return l4::test(f) && ntoh16(f.d + f.l4 + 2) == P; }
+};
+
+template <uint16_t P>
+struct any_port: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f) { return l4::test(f) && (ntoh16(f.d + f.l4) == P || ntoh16(f.d + f.l4 + 2) == P); }
+};
+
+// offset 12: source, 16: destination
+template <int OFFSET, uint32_t IP>
+struct ip_at: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f) { return ipv4::test(f) && ntoh32(f.d + ETH_HDR_LEN + OFFSET) == IP; }
+};
+
+// any of the flags in mask (1:FIN 2:SYN 4:RST 8:PSH 16:ACK 32:URG)
+template <uint8_t MASK>
+struct tcp_flags: filter
+{
+    static NETDUMP_FILTER_INLINE bool test (layers& f)
+    {
+        return ip_proto<6>::test(f)
+            && !(ntoh16(f.d + ETH_HDR_LEN + 6) & 0x1fff)
+            && f.size >= f.l4 + 14u
+            && (f.d[f.l4 + 13] & MASK);
+    }
+};
+
+constexpr uint32_t ip (uint8_t a, uint8_t b, uint8_t c, uint8_t d) { return ((uint32_t)a << 24) | ((uint32_t)b << 16) | (c << 8) | d; }
+
+constexpr ipv4              Ipv4 { };
+constexpr ethtype<0x86dd>   Ipv6 { };
+constexpr arp               Arp { };
+constexpr arp_op<1>         ArpWho { };
+constexpr arp_op<2>         ArpIs { };
+constexpr ip_proto<1>       Icmp { };
+constexpr ip_proto<2>       Igmp { };
+constexpr ip_proto<6>       Tcp { };
+constexpr ip_proto<17>      Udp { };
+
+template <uint16_t T> constexpr ethtype<T>   EthType { };
+template <uint8_t P>  constexpr ip_proto<P>  IpProto { };
+template <uint16_t P> constexpr src_port<P>  SrcPort { };
+template <uint16_t P> constexpr dst_port<P>  DstPort { };
+template <uint16_t P> constexpr any_port<P>  Port { };
+template <uint8_t M>  constexpr tcp_flags<M> TcpFlags { };
+// SrcHost<ip(192, 168, 0, 1)>
+template <uint32_t IP> constexpr ip_at<12, IP> SrcHost { };
+template <uint32_t IP> constexpr ip_at<16, IP> DstHost { };
+template <uint32_t IP> constexpr either<ip_at<12, IP>, ip_at<16, IP>> Host { };
+
+template <typename F, typename = if_filter<F>>
+inline bool match (F, const char* data, size_t size)
+{
+    layers f { data, size, 0, false };
+    return F::test(f);
+}
+
+// phy_capture gate, F: decltype(a constexpr filter)
+typedef void (*capture_fn) (int netif_idx, const char* data, size_t len, int out, int success);
+
+template <typename F, capture_fn next>
+void gate (int netif_idx, const char* data, size_t len, int out, int success)
+{
+    layers f { data, len, 0, false };
+    if (F::test(f))
+        next(netif_idx, data, len, out, success);
+}
+
+} // namespace netdump_filter
+
+#endif // __NETDUMP_FILTER_H
@@ -14,17 +14,38 @@ inline void startPingAlive (uint32_t ipv4 = 0)
   start_pingalive(ipv4?: (uint32_t)WiFi.gatewayIP());
 }
 
+// probes count addresses starting from first (ex: 254 hosts from x.x.x.1)
+// done() is called when all are answered or timed out
+inline int startPingSweep (struct ping_sweep* sweep, uint32_t first, uint16_t count = 254, void (*done) (struct ping_sweep*) = nullptr)
+{
+  ip_addr_t addr = IPADDR4_INIT(first);
+  return ping_sweep_start(sweep, &addr, count, done);
+}
+
+// sends count back-to-back echoes of size bytes to ipv4 (default: gateway)
+// done() is called when all replies are received or timed out
+inline int startPingTrain (struct ping_train* train, uint16_t size = 1024, uint8_t count = 8, void (*done) (struct ping_train*) = nullptr, uint32_t ipv4 = 0)
+{
+  ip_addr_t addr = IPADDR4_INIT(ipv4?: (uint32_t)WiFi.gatewayIP());
+  return ping_train_start(train, &addr, size, count, done);
+}
+
 // to be defined by user
 extern void pingFault (void);
 
 // informative variables
 extern uint16_t ping_seq_num_send;
 extern uint16_t ping_seq_num_recv;
+extern uint32_t ping_rtt_ms;        // last round-trip time
 
 // set this to 1 to stop ping
 // (will be stopped when it reads 0)
 extern uint8_t ping_should_stop;
 
+// set this to 1 to pause ping while the radio is off
+// (no probe is sent, no fault is detected)
+extern uint8_t ping_paused;
+
 } // extern "C"
 #endif // __cplusplus
 
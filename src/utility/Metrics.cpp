@@ -0,0 +1,222 @@
+/*
+ Metrics - counters, gauges and histograms in Prometheus text format
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <ESP8266WiFi.h>
+#include <Metrics.h>
+
+static metric* metrics = nullptr;
+static metric* metrics_last = nullptr;
+
+metric::metric (metric_type type, const __FlashStringHelper* name, const __FlashStringHelper* help, int32_t (*read) ()):
+    next(nullptr), name(name), help(help), type(type), value(0), read(read),
+    bounds(nullptr), buckets(nullptr), nbounds(0), sum(0)
+{
+    // keep declaration order
+    if (metrics_last)
+        metrics_last->next = this;
+    else
+        metrics = this;
+    metrics_last = this;
+}
+
+metric::metric (const __FlashStringHelper* name, const __FlashStringHelper* help, const int32_t* bounds, uint32_t* buckets, uint8_t nbounds):
+    metric(METRIC_HISTOGRAM, name, help)
+{
+    this->bounds = bounds;
+    this->buckets = buckets;
+    this->nbounds = nbounds;
+    memset(buckets, 0, (nbounds + 1) * sizeof(buckets[0]));
+}
+
+void metric::observe (int32_t v)
+{
+    uint8_t i = 0;
+    while (i < nbounds && v > bounds[i])
+        i++;
+    buckets[i]++;
+    sum += v;
+}
+
+////////////////////////////////////////
+// library metrics
+// weak: ping.c is not built with lwIP v1 (or without LWIP_RAW), its metrics
+// are then not rendered
+
+extern size_t tcpdump_err;
+extern "C" uint16_t ping_seq_num_send __attribute__((weak));
+extern "C" uint16_t ping_seq_num_recv __attribute__((weak));
+
+static int32_t read_heap_free ()          { return ESP.getFreeHeap(); }
+static int32_t read_heap_max_block ()     { return ESP.getMaxFreeBlockSize(); }
+static int32_t read_heap_fragmentation () { return ESP.getHeapFragmentation(); }
+static int32_t read_tcpdump_err ()        { return tcpdump_err; }
+static int32_t read_ping_send ()          { return ping_seq_num_send; }
+static int32_t read_ping_recv ()          { return ping_seq_num_recv; }
+
+static metric heap_free          (METRIC_GAUGE,   F("esp_heap_free_bytes"),           F("free heap"), read_heap_free);
+static metric heap_max_block     (METRIC_GAUGE,   F("esp_heap_max_block_bytes"),      F("largest free heap block"), read_heap_max_block);
+static metric heap_fragmentation (METRIC_GAUGE,   F("esp_heap_fragmentation_percent"), F("heap fragmentation"), read_heap_fragmentation);
+static metric capture_drops      (METRIC_COUNTER, F("netdump_capture_drops_total"),   F("packets not captured (no room)"), read_tcpdump_err);
+static metric ping_sent          (METRIC_GAUGE,   F("pingalive_seq_sent"),            F("last ping sequence number sent"), read_ping_send);
+static metric ping_received      (METRIC_GAUGE,   F("pingalive_seq_received"),        F("last ping sequence number received"), read_ping_recv);
+
+static const int32_t ping_rtt_bounds [] = { 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+static metric_histogram<9> ping_rtt (F("pingalive_rtt_ms"), F("ping round-trip time"), ping_rtt_bounds);
+
+// weak: a sketch can still define its own ping_rtt_hook(), the histogram
+// then stays empty
+extern "C" void __attribute__((weak)) ping_rtt_hook (uint32_t ms)
+{
+    ping_rtt.observe(ms);
+}
+
+static bool metric_present (const metric* m)
+{
+    if (m == &ping_sent || m == &ping_rtt)
+        return &ping_seq_num_send;
+    if (m == &ping_received)
+        return &ping_seq_num_recv;
+    return true;
+}
+
+////////////////////////////////////////
+// rendering
+
+// writes by chunks instead of one tcp segment per printf()
+class metrics_buffer: public Print
+{
+public:
+    metrics_buffer (Print& out): out(out), len(0) { }
+    ~metrics_buffer () { flush(); }
+
+    size_t write (uint8_t c) override
+    {
+        if (len == sizeof(buf))
+            flush();
+        buf[len++] = c;
+        return 1;
+    }
+
+    size_t write (const uint8_t* data, size_t size) override
+    {
+        for (size_t i = 0; i < size; i++)
+            write(data[i]);
+        return size;
+    }
+
+    void flush () override
+    {
+        if (len)
+            out.write(buf, len);
+        len = 0;
+    }
+
+protected:
+    Print& out;
+    size_t len;
+    uint8_t buf [128];
+};
+
+static void render (Print& out, const metric* m)
+{
+    static const char* const types [] = { "counter", "gauge", "histogram" };
+
+    // lines end with \n only, println()'s \r is not allowed by the format
+    out.print(F("# HELP "));
+    out.print(m->name);
+    out.print(' ');
+    out.print(m->help);
+    out.print('\n');
+    out.print(F("# TYPE "));
+    out.print(m->name);
+    out.printf(" %s\n", types[m->type]);
+
+    if (m->type != METRIC_HISTOGRAM)
+    {
+        int32_t value = m->read? m->read(): m->value;
+        out.print(m->name);
+        if (m->type == METRIC_COUNTER)
+            out.printf(" %u\n", (unsigned)value);
+        else
+            out.printf(" %d\n", (int)value);
+        return;
+    }
+
+    uint32_t count = 0;
+    for (uint8_t i = 0; i <= m->nbounds; i++)
+    {
+        count += m->buckets[i];
+        out.print(m->name);
+        if (i < m->nbounds)
+            out.printf("_bucket{le=\"%d\"} %u\n", (int)m->bounds[i], (unsigned)count);
+        else
+            out.printf("_bucket{le=\"+Inf\"} %u\n", (unsigned)count);
+    }
+    out.print(m->name);
+    out.printf("_sum %lld\n", (long long)m->sum);
+    out.print(m->name);
+    out.printf("_count %u\n", (unsigned)count);
+}
+
+void metrics_render (Print& out)
+{
+    metrics_buffer buffered(out);
+    for (const metric* m = metrics; m; m = m->next)
+        if (metric_present(m))
+            render(buffered, m);
+}
+
+////////////////////////////////////////
+// http server
+
+static WiFiServer metrics_server(9100); // port will be overwritten
+
+bool metrics_setup (uint16_t port)
+{
+    metrics_server.begin(port);
+    return true;
+}
+
+void metrics_loop ()
+{
+    if (!metrics_server.hasClient())
+        return;
+
+    WiFiClient client = metrics_server.available();
+
+    // the request is not needed, wait for its end
+    unsigned long start = millis();
+    int eol = 0;
+    while (client.connected() && eol < 2 && millis() - start < 1000)
+    {
+        int c = client.read();
+        if (c < 0)
+            yield();
+        else if (c == '\n')
+            eol++;
+        else if (c != '\r')
+            eol = 0;
+    }
+
+    client.print(F("HTTP/1.0 200 OK\r\n"
+                   "Content-Type: text/plain; version=0.0.4\r\n"
+                   "Connection: close\r\n"
+                   "\r\n"));
+    metrics_render(client);
+    client.stop();
+}
@@ -21,6 +21,7 @@
 
 #include <NetDump.h>
 #include <lwip/init.h>
+#include "chksum.h"
 
 #if LWIP_VERSION_MAJOR != 1
 
@@ -53,7 +54,7 @@ static void netDumpARP (Print& out, const char* ethdata, size_t size)
 {
     out.print(F(" ARP "));
     if (size < ETH_HDR_LEN + 28)
-        return;
+        return snap(out);
     char type = netDump_getARPType(ethdata);
     if (type == 1)
     {
@@ -76,23 +77,23 @@ static void netDumpARP (Print& out, const char* ethdata, size_t size)
 static void netDumpICMP (Print& out, const char* ethdata, size_t size)
 {
     out.print(F(" ICMP "));
-    if (size < 1)
+    size_t icmp = ETH_HDR_LEN + netDump_getIpHdrLen(ethdata);
+    if (size < icmp + 1)
         return snap(out);
         
-    switch (ethdata[ETH_HDR_LEN + 20 + 0])
+    switch (ethdata[icmp])
     {
     case 0: out.println(F("ping reply")); break;
     case 8: out.println(F("ping request")); break;
-    default: out.printf("type(0x%02x)\r\n", ethdata[ETH_HDR_LEN + 20 + 0]);
+    default: out.printf("type(0x%02x)\r\n", (unsigned char)ethdata[icmp]);
     }
 }
 
 static void netDumpIGMP (Print& out, const char* ethdata, size_t size)
 {
     out.println(F(" IGMP"));
-    if (size < 1)
-        return snap(out);
     (void)ethdata;
+    (void)size;
 }
 
 static void netDumpPort (Print& out, const char* ethdata)
@@ -114,12 +115,19 @@ void netDumpTCPFlags (Print& out, const char* ethdata)
 static void netDumpTCP (Print& out, const char* ethdata, size_t size)
 {
     out.print(F(" TCP "));
-    if (size < ETH_HDR_LEN + 20 + 16)
+    size_t tcp = ETH_HDR_LEN + netDump_getIpHdrLen(ethdata);
+    if (size < tcp + 16)
         return snap(out);
     netDumpPort(out, ethdata);
     netDumpTCPFlags(out, ethdata);
 
-    uint16_t tcplen = netDump_getIpUsrLen(ethdata) - netDump_getTcpHdrLen(ethdata);
+    int tcplen = (int)netDump_getIpTotLen(ethdata) - netDump_getIpHdrLen(ethdata) - netDump_getTcpHdrLen(ethdata);
+    if (tcplen < 0)
+    {
+        // headers longer than the ip packet
+        out.print(F(" len?"));
+        tcplen = 0;
+    }
     uint32_t seq = netDump_getTcpSeq(ethdata);
     out.printf(" seq:%u", seq);
     if (tcplen)
@@ -128,24 +136,36 @@ static void netDumpTCP (Print& out, const char* ethdata, size_t size)
         (unsigned)netDump_getTcpAck(ethdata),
         netDump_getTcpWindow(ethdata));
     if (tcplen)
-        out.printf(" len=%u", tcplen);
+        out.printf(" len=%d", tcplen);
     
-    size_t options = ETH_HDR_LEN + netDump_getIpHdrLen(ethdata) + 20;
-    size_t options_len = netDump_getTcpHdrLen(ethdata) - 20;
+    // options, as far as they were captured
+    size_t options = tcp + 20;
+    size_t options_len = netDump_getTcpHdrLen(ethdata);
+    options_len = options_len > 20? options_len - 20: 0;
+    if (options_len > (size > options? size - options: 0))
+        options_len = size > options? size - options: 0;
     for (size_t i = 0; i < options_len; )
     {
         uint8_t opt = ethdata[options + i];
-        uint8_t sz = opt >= 2? ethdata[options + i + 1]: 1;
-        switch (opt)
+        if (!opt)
+            // end of option list
+            break;
+        if (opt == 1)
         {
-        case 0:
-        case 1: break;
-        case 2: out.printf(" mss=%u", ntoh16(ethdata + options + i + 2)); break;
-        default: out.printf(" opt%u(%u)", opt, sz);
+            // no-operation
+            i++;
+            continue;
         }
-        if (!opt)
-            // end of option
+        if (i + 1 >= options_len)
+            break;
+        uint8_t sz = ethdata[options + i + 1];
+        if (sz < 2 || i + sz > options_len)
+            // malformed or snapped
             break;
+        if (opt == 2 && sz == 4)
+            out.printf(" mss=%u", ntoh16(ethdata + options + i + 2));
+        else
+            out.printf(" opt%u(%u)", opt, sz);
         i += sz;
     }
 
@@ -155,7 +175,7 @@ static void netDumpTCP (Print& out, const char* ethdata, size_t size)
 static void netDumpUDP (Print& out, const char* ethdata, size_t size)
 {
     out.print(F(" UDP "));
-    if (size < ETH_HDR_LEN + 20 + 8)
+    if (size < ETH_HDR_LEN + netDump_getIpHdrLen(ethdata) + 8u)
         return snap(out);
 
     netDumpPort(out, ethdata);
@@ -166,6 +186,46 @@ static void netDumpUDP (Print& out, const char* ethdata, size_t size)
     out.printf(" len=%d\r\n", udplen);
 }
 
+int netDump_badSums (const char* ethdata, size_t size)
+{
+    if (!netDump_is_IPv4(ethdata) || size < ETH_HDR_LEN + 20)
+        return 0;
+
+    size_t iphdr = netDump_getIpHdrLen(ethdata);
+    if (iphdr < 20 || size < ETH_HDR_LEN + iphdr)
+        return 0;
+    int bad = 0;
+    if (chksum(ethdata + ETH_HDR_LEN, iphdr))
+        bad |= NETDUMP_SUM_BAD_IP;
+
+    size_t iplen = netDump_getIpTotLen(ethdata);
+    if (   iplen < iphdr
+        || size < ETH_HDR_LEN + iplen
+        || (ntoh16(ethdata + ETH_HDR_LEN + 6) & 0x3fff))
+        // snapped or fragmented
+        return bad;
+
+    const char* l4 = ethdata + ETH_HDR_LEN + iphdr;
+    size_t l4len = iplen - iphdr;
+    uint32_t sum;
+    if (netDump_is_ICMP(ethdata))
+        sum = chksum_add(l4, l4len, 0);
+    else if (   (netDump_is_TCP(ethdata) && l4len >= 20)
+             || (netDump_is_UDP(ethdata) && l4len >= 8 && (l4[6] || l4[7])))
+    {
+        // pseudo header
+        const char pseudo [] = { 0, (char)netDump_getIpType(ethdata), (char)(l4len >> 8), (char)l4len };
+        sum = chksum_add(ethdata + ETH_HDR_LEN + 12, 8, 0);
+        sum = chksum_add(pseudo, 4, sum);
+        sum = chksum_add(l4, l4len, sum);
+    }
+    else
+        return bad;
+    if (chksum_fold(sum))
+        bad |= NETDUMP_SUM_BAD_L4;
+    return bad;
+}
+
 static void netDumpIPv4 (Print& out, const char* ethdata, size_t size)
 {
     if (size < ETH_HDR_LEN + 20)
@@ -177,6 +237,17 @@ static void netDumpIPv4 (Print& out, const char* ethdata, size_t size)
     out.print('>');
     netDumpIPv4(out, ethdata + ETH_HDR_LEN + 16);
     //out.printf(" (iphdrlen=%d)", netDump_getIpHdrLen(ethdata));
+    if (netDump_getIpHdrLen(ethdata) < 20)
+    {
+        out.printf(" hdrlen=%d?\r\n", netDump_getIpHdrLen(ethdata));
+        return;
+    }
+
+    int bad = netDump_badSums(ethdata, size);
+    if (bad & NETDUMP_SUM_BAD_IP)
+        out.print(F(" [bad ip cksum]"));
+    if (bad & NETDUMP_SUM_BAD_L4)
+        out.print(F(" [bad cksum]"));
 
     if      (netDump_is_ICMP(ethdata)) netDumpICMP(out, ethdata, size);
     else if (netDump_is_IGMP(ethdata)) netDumpIGMP(out, ethdata, size);
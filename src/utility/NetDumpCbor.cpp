@@ -0,0 +1,150 @@
+/*
+ NetDump library - tcpdump-like packet logger facility
+
+ Copyright (c) 2018 David Gauchard. All rights reserved.
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <NetDump.h>
+
+// cbor (rfc8949) encoder, streaming: nothing is allocated or buffered
+// besides one item head
+
+static void cbor_head (Print& out, uint8_t major, uint64_t value)
+{
+    uint8_t head [9];
+    size_t len;
+    major <<= 5;
+    if (value < 24)
+    {
+        head[0] = major | value;
+        len = 1;
+    }
+    else
+    {
+        int bytes = value <= 0xff? 1: value <= 0xffff? 2: value <= 0xffffffff? 4: 8;
+        head[0] = major | (bytes == 1? 24: bytes == 2? 25: bytes == 4? 26: 27);
+        for (int i = 0; i < bytes; i++)
+            head[1 + i] = value >> (8 * (bytes - 1 - i));
+        len = 1 + bytes;
+    }
+    out.write(head, len);
+}
+
+static void cbor_uint (Print& out, uint8_t key, uint64_t value)
+{
+    cbor_head(out, 0, key);
+    cbor_head(out, 0, value);
+}
+
+static void cbor_bytes (Print& out, uint8_t key, const char* data, size_t len)
+{
+    cbor_head(out, 0, key);
+    cbor_head(out, 2, len);
+    out.write((const uint8_t*)data, len);
+}
+
+void netDumpCbor (Print& out, const char* ethdata, size_t size, int netif_idx, int out_dir, uint64_t time_us, size_t payload, bool macs)
+{
+    // indefinite length map: fields are not counted beforehand
+    static const uint8_t map_begin = 0xbf, map_end = 0xff;
+    out.write(&map_begin, 1);
+
+    if (time_us)
+        cbor_uint(out, NETDUMP_CBOR_TIME, time_us);
+    if (out_dir >= 0)
+        cbor_uint(out, NETDUMP_CBOR_OUT, out_dir);
+    if (netif_idx >= 0)
+        cbor_uint(out, NETDUMP_CBOR_NETIF, netif_idx);
+
+    // redundant fields are left out: size when the whole ip packet is there,
+    // ethtype for ipv4 and arp
+    bool ipv4 = size >= ETH_HDR_LEN + 20 && netDump_is_IPv4(ethdata);
+    if (!ipv4 || size < ETH_HDR_LEN + (size_t)netDump_getIpTotLen(ethdata))
+        cbor_uint(out, NETDUMP_CBOR_SIZE, size);
+
+    if (size >= ETH_HDR_LEN)
+    {
+        if (macs)
+        {
+            cbor_bytes(out, NETDUMP_CBOR_DST_MAC, ethdata, 6);
+            cbor_bytes(out, NETDUMP_CBOR_SRC_MAC, ethdata + 6, 6);
+        }
+
+        if (netDump_is_ARP(ethdata) && size >= ETH_HDR_LEN + 28)
+        {
+            cbor_uint(out, NETDUMP_CBOR_ARP_OP, netDump_getARPType(ethdata));
+            cbor_bytes(out, NETDUMP_CBOR_SRC_IP, ethdata + ETH_HDR_LEN + 14, 4);
+            cbor_bytes(out, NETDUMP_CBOR_DST_IP, ethdata + ETH_HDR_LEN + 24, 4);
+            if (netDump_is_ARP_is(ethdata))
+                cbor_bytes(out, NETDUMP_CBOR_ARP_MAC, ethdata + ETH_HDR_LEN + 8, 6);
+        }
+        else if (ipv4)
+        {
+            size_t l4 = ETH_HDR_LEN + netDump_getIpHdrLen(ethdata);
+            size_t usr = 0;
+            cbor_bytes(out, NETDUMP_CBOR_SRC_IP, ethdata + ETH_HDR_LEN + 12, 4);
+            cbor_bytes(out, NETDUMP_CBOR_DST_IP, ethdata + ETH_HDR_LEN + 16, 4);
+            cbor_uint(out, NETDUMP_CBOR_PROTO, netDump_getIpType(ethdata));
+            cbor_uint(out, NETDUMP_CBOR_LEN, netDump_getIpTotLen(ethdata));
+
+            if (netDump_is_TCP(ethdata) && size >= l4 + 20)
+            {
+                cbor_uint(out, NETDUMP_CBOR_SRC_PORT, netDump_getSrcPort(ethdata));
+                cbor_uint(out, NETDUMP_CBOR_DST_PORT, netDump_getDstPort(ethdata));
+                cbor_uint(out, NETDUMP_CBOR_FLAGS, netDump_getTcpFlags(ethdata) & 0x1ff);
+                cbor_uint(out, NETDUMP_CBOR_SEQ, netDump_getTcpSeq(ethdata));
+                cbor_uint(out, NETDUMP_CBOR_ACK, netDump_getTcpAck(ethdata));
+                cbor_uint(out, NETDUMP_CBOR_WINDOW, netDump_getTcpWindow(ethdata));
+                usr = netDump_getTcpHdrLen(ethdata);
+                cbor_uint(out, NETDUMP_CBOR_USR_LEN, netDump_getTcpUsrLen(ethdata));
+            }
+            else if (netDump_is_UDP(ethdata) && size >= l4 + 8)
+            {
+                cbor_uint(out, NETDUMP_CBOR_SRC_PORT, netDump_getSrcPort(ethdata));
+                cbor_uint(out, NETDUMP_CBOR_DST_PORT, netDump_getDstPort(ethdata));
+                usr = 8;
+                cbor_uint(out, NETDUMP_CBOR_USR_LEN, netDump_getUdpUsrLen(ethdata));
+            }
+            else if (netDump_is_ICMP(ethdata) && size >= l4 + 4)
+            {
+                cbor_uint(out, NETDUMP_CBOR_ICMP_TYPE, (uint8_t)ethdata[l4]);
+                usr = 4;
+            }
+
+            int bad = netDump_badSums(ethdata, size);
+            if (bad)
+                cbor_uint(out, NETDUMP_CBOR_BAD_SUMS, bad);
+
+            // payload slice, as captured, without the ethernet padding
+            size_t end = ETH_HDR_LEN + (size_t)netDump_getIpTotLen(ethdata);
+            if (end > size)
+                end = size;
+            if (payload && usr && end > l4 + usr)
+            {
+                size_t len = end - l4 - usr;
+                if (len > payload)
+                    len = payload;
+                cbor_bytes(out, NETDUMP_CBOR_PAYLOAD, ethdata + l4 + usr, len);
+            }
+        }
+        else
+            cbor_uint(out, NETDUMP_CBOR_ETHTYPE, netDump_ethtype(ethdata));
+    }
+
+    out.write(&map_end, 1);
+}
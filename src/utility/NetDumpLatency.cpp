@@ -0,0 +1,262 @@
+/*
+ NetDump library - tcpdump-like packet logger facility
+
+ Copyright (c) 2018 David Gauchard. All rights reserved.
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+#include <NetDump.h>
+
+// dns and dhcp transaction latency, from captured packets only
+
+#define DNS_PORT            53
+#define DHCP_SERVER_PORT    67
+#define DHCP_CLIENT_PORT    68
+
+// dhcp message types (option 53)
+#define DHCP_DISCOVER       1
+#define DHCP_OFFER          2
+#define DHCP_REQUEST        3
+#define DHCP_ACK            5
+#define DHCP_NAK            6
+
+// DISCOVERs are broadcast and their server is not known until an OFFER comes
+// back (if ever): answers, retries and timeouts all go to this one entry
+#define DHCP_ANY_SERVER     0xffffffff
+
+struct pending
+{
+    uint32_t key;       // dns id or dhcp xid
+    uint32_t server;    // where the request went, network order
+    uint32_t sent_ms;   // first transmission
+    uint8_t  kind;
+    bool     used;
+};
+
+static pending pendings[NETDUMP_LATENCY_PENDING];
+static netdump_latency stats;
+
+static netdump_latency_server* server_for (uint32_t ip, uint8_t kind)
+{
+    netdump_latency_server* free = nullptr;
+    for (auto& s: stats.servers)
+    {
+        if (s.used && s.ip == ip && s.kind == kind)
+            return &s;
+        if (!s.used && !free)
+            free = &s;
+    }
+    if (!free)
+    {
+        stats.overflow++;
+        return nullptr;
+    }
+    memset(free, 0, sizeof(*free));
+    free->used = true;
+    free->ip = ip;
+    free->kind = kind;
+    return free;
+}
+
+static void expire (uint32_t now)
+{
+    for (auto& p: pendings)
+        if (p.used && now - p.sent_ms >= NETDUMP_LATENCY_TIMEOUT)
+        {
+            p.used = false;
+            netdump_latency_server* s = server_for(p.server, p.kind);
+            if (s)
+                s->timeouts++;
+        }
+}
+
+static void request (uint8_t kind, uint32_t key, uint32_t server, uint32_t now)
+{
+    pending* free = nullptr;
+    for (auto& p: pendings)
+    {
+        if (p.used && p.kind == kind && p.key == key)
+        {
+            // retransmission, latency still counts from the first one,
+            // charged to the server that did not answer: lwIP sends dns
+            // retries to the next server with the same id
+            netdump_latency_server* s = server_for(p.server, kind);
+            if (s)
+                s->retries++;
+            p.server = server;
+            return;
+        }
+        if (!p.used && !free)
+            free = &p;
+    }
+    if (!free)
+    {
+        stats.overflow++;
+        return;
+    }
+    free->used = true;
+    free->kind = kind;
+    free->key = key;
+    free->server = server;
+    free->sent_ms = now;
+}
+
+static void response (uint8_t kind, uint32_t key, uint32_t server, uint32_t now)
+{
+    for (auto& p: pendings)
+        if (p.used && p.kind == kind && p.key == key
+            && (kind != NETDUMP_LATENCY_DNS || p.server == server))
+        {
+            p.used = false;
+            netdump_latency_server* s = server_for(server, kind);
+            if (!s)
+                return;
+            uint32_t ms = now - p.sent_ms;
+            if (!s->answered || ms < s->min_ms)
+                s->min_ms = ms;
+            if (ms > s->max_ms)
+                s->max_ms = ms;
+            s->sum_ms += ms;
+            s->answered++;
+            int bucket = 0;
+            while (ms > 1 && bucket < NETDUMP_LATENCY_HIST - 1)
+            {
+                ms >>= 1;
+                bucket++;
+            }
+            s->hist[bucket]++;
+            return;
+        }
+    stats.unmatched++;
+}
+
+// dhcp message type and server identifier options
+static int dhcp_type (const uint8_t* bootp, size_t len, uint32_t* server_id)
+{
+    static const uint8_t cookie [] = { 99, 130, 83, 99 };
+    if (len < 240 || memcmp(bootp + 236, cookie, 4))
+        return 0;
+    int type = 0;
+    for (size_t i = 240; i < len && bootp[i] != 255; )
+    {
+        uint8_t opt = bootp[i];
+        if (opt == 0)
+        {
+            // pad
+            i++;
+            continue;
+        }
+        if (i + 2 > len || i + 2 + bootp[i + 1] > len)
+            break;
+        if (opt == 53 && bootp[i + 1] >= 1)
+            type = bootp[i + 2];
+        else if (opt == 54 && bootp[i + 1] == 4)
+            memcpy(server_id, bootp + i + 2, 4);
+        i += 2 + bootp[i + 1];
+    }
+    return type;
+}
+
+void netDumpLatency (int netif_idx, const char* ethdata, size_t size, int out, int success)
+{
+    (void)netif_idx;
+    (void)success;
+
+    if (   size < ETH_HDR_LEN + 20 + 8
+        || !netDump_is_IPv4(ethdata)
+        || !netDump_is_UDP(ethdata))
+        return;
+    size_t l4 = ETH_HDR_LEN + netDump_getIpHdrLen(ethdata);
+    if (size < l4 + 8)
+        return;
+    uint16_t sport = netDump_getSrcPort(ethdata);
+    uint16_t dport = netDump_getDstPort(ethdata);
+    const uint8_t* payload = (const uint8_t*)ethdata + l4 + 8;
+    size_t len = size - l4 - 8;
+
+    uint32_t src, dst;
+    memcpy(&src, ethdata + ETH_HDR_LEN + 12, 4);
+    memcpy(&dst, ethdata + ETH_HDR_LEN + 16, 4);
+    uint32_t now = millis();
+    expire(now);
+
+    if ((out? dport: sport) == DNS_PORT && len >= 12)
+    {
+        uint32_t id = (payload[0] << 8) | payload[1];
+        bool answer = payload[2] & 0x80;
+        if (out && !answer)
+            request(NETDUMP_LATENCY_DNS, id, dst, now);
+        else if (!out && answer)
+            response(NETDUMP_LATENCY_DNS, id, src, now);
+    }
+    else if (   (out && sport == DHCP_CLIENT_PORT && dport == DHCP_SERVER_PORT)
+             || (!out && sport == DHCP_SERVER_PORT && dport == DHCP_CLIENT_PORT))
+    {
+        uint32_t server_id = 0;
+        int type = dhcp_type(payload, len, &server_id);
+        uint32_t xid;
+        memcpy(&xid, payload + 4, 4);
+        switch (type)
+        {
+        case DHCP_DISCOVER: request(NETDUMP_LATENCY_DHCP_DISCOVER, xid, DHCP_ANY_SERVER, now); break;
+        case DHCP_REQUEST:  request(NETDUMP_LATENCY_DHCP_REQUEST, xid, server_id? server_id: dst, now); break;
+        case DHCP_OFFER:    response(NETDUMP_LATENCY_DHCP_DISCOVER, xid, DHCP_ANY_SERVER, now); break;
+        case DHCP_ACK:
+        case DHCP_NAK:      response(NETDUMP_LATENCY_DHCP_REQUEST, xid, server_id? server_id: src, now); break;
+        }
+    }
+}
+
+void netDumpLatencySnapshot (netdump_latency* snapshot)
+{
+    // requests that will not be answered are accounted for now
+    expire(millis());
+    memcpy(snapshot, &stats, sizeof(stats));
+}
+
+void netDumpLatencyReset ()
+{
+    memset(&stats, 0, sizeof(stats));
+    memset(pendings, 0, sizeof(pendings));
+}
+
+void netDumpLatencyPrint (Print& out)
+{
+    static const char* const kinds [] = { "dns", "dhcp-discover", "dhcp-request" };
+    netdump_latency s;
+    netDumpLatencySnapshot(&s);
+    for (const auto& server: s.servers)
+        if (server.used)
+        {
+            out.printf("%-13s ", kinds[server.kind]);
+            netDumpIPv4(out, (const char*)&server.ip);
+            out.printf(" answered:%u retries:%u timeouts:%u",
+                (unsigned)server.answered, (unsigned)server.retries, (unsigned)server.timeouts);
+            if (server.answered)
+                out.printf(" ms min/avg/max:%u/%u/%u",
+                    (unsigned)server.min_ms, (unsigned)(server.sum_ms / server.answered), (unsigned)server.max_ms);
+            for (int i = 0; i < NETDUMP_LATENCY_HIST; i++)
+                if (server.hist[i] && i == NETDUMP_LATENCY_HIST - 1)
+                    out.printf(" >=%ums:%u", 1U << i, server.hist[i]);
+                else if (server.hist[i])
+                    out.printf(" <%ums:%u", 2U << i, server.hist[i]);
+            out.println();
+        }
+    if (s.unmatched || s.overflow)
+        out.printf("unmatched:%u overflow:%u\r\n", (unsigned)s.unmatched, (unsigned)s.overflow);
+}
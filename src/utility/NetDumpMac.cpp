@@ -20,55 +20,208 @@
 */
 
 #include <NetDump.h>
+#include <lwip/init.h>
+
+#if LWIP_VERSION_MAJOR != 1
 
-#if 0
 #include <lwip/netif.h>
 #include <lwip/etharp.h>
 
-// WIP - attempt to show correct mac addresses for output packets
-void netDumpMacsForOutput (Print& out, const char* ethdata, char netif_idx)
+// output frames given to phy_capture carry placeholder mac addresses
+// (00:20:00:00:00:00>aa:aa:03:00:00:00), they are rebuilt here:
+// - source is the netif hwaddr
+// - destination is broadcast, multicast, or the next hop (host or gateway)
+//   from lwIP's etharp table, which is checked first on every frame so that
+//   a changed mac is shown at once
+// - the direct-mapped ip->mac cache keeps the addresses etharp has already
+//   recycled or expired, it is fed by etharp and by incoming arp packets
+
+struct arp_entry
+{
+    uint32_t ip;        // network order
+    uint32_t stamp_ms;
+    uint8_t mac[6];
+    uint8_t netif;
+    uint8_t state;
+};
+
+enum { ARP_FREE, ARP_KNOWN };
+
+static arp_entry arp_cache[NETDUMP_ARP_CACHE];
+
+static arp_entry* arp_slot (uint32_t ip)
+{
+    return &arp_cache[((ip * 2654435761u) >> 16) & (NETDUMP_ARP_CACHE - 1)];
+}
+
+static struct netif* netif_from_idx (int netif_idx)
+{
+    for (struct netif* netif = netif_list; netif; netif = netif->next)
+        if (netif->num == netif_idx)
+            return netif;
+    return nullptr;
+}
+
+static void arp_store (arp_entry* e, uint32_t ip, int netif_idx, const void* mac)
+{
+    e->ip = ip;
+    e->netif = netif_idx;
+    e->stamp_ms = millis();
+    memcpy(e->mac, mac, 6);
+    e->state = ARP_KNOWN;
+}
+
+// etharp's stable entry for ip, nullptr if none
+static const uint8_t* etharp_mac (uint32_t ip, struct netif* netif)
+{
+    ip4_addr_t addr;
+    struct eth_addr* eth_ret;
+    const ip4_addr_t* ip_ret;
+    ip4_addr_set_u32(&addr, ip);
+    if (etharp_find_addr(netif, &addr, &eth_ret, &ip_ret) < 0)
+        return nullptr;
+    return eth_ret->addr;
+}
+
+static const uint8_t* arp_lookup (uint32_t ip, struct netif* netif)
+{
+    arp_entry* e = arp_slot(ip);
+
+    // etharp is authoritative (ARP_TABLE_SIZE entries, scanned linearly)
+    const uint8_t* mac = etharp_mac(ip, netif);
+    if (mac)
+    {
+        arp_store(e, ip, netif->num, mac);
+        return e->mac;
+    }
+
+    // no longer in etharp: the last known one
+    if (   e->state == ARP_KNOWN && e->ip == ip && e->netif == netif->num
+        && millis() - e->stamp_ms < NETDUMP_ARP_MAXAGE)
+        return e->mac;
+    return nullptr;
+}
+
+void netDumpArpLearn (const char* ethdata, size_t size, int netif_idx)
+{
+    if (   size < ETH_HDR_LEN + 28
+        || !netDump_is_ARP(ethdata)
+        || !(netDump_is_ARP_who(ethdata) || netDump_is_ARP_is(ethdata)))
+        return;
+
+    // sender's addresses are valid in both requests and replies
+    uint32_t ip;
+    memcpy(&ip, ethdata + ETH_HDR_LEN + 14, 4);
+    if (!ip)
+        // probe
+        return;
+    arp_entry* e = arp_slot(ip);
+    arp_store(e, ip, netif_idx, ethdata + ETH_HDR_LEN + 8);
+}
+
+void netDumpArpFlush ()
+{
+    memset(arp_cache, 0, sizeof(arp_cache));
+}
+
+bool netDumpMacsResolve (char* macs, const char* ethdata, size_t size, int netif_idx, int out)
 {
-    uint32_t ip = 0;
-    if (netDump_is_IPv4(ethdata))
-        memcpy(&ip, ethdata + ETH_HDR_LEN + 16, 4);
-    else if (netDump_is_ARP(ethdata))
+    if (!out)
+    {
+        netDumpArpLearn(ethdata, size, netif_idx);
+        if (macs != ethdata)
+            memcpy(macs, ethdata, 12);
+        return true;
+    }
+
+    if (size < ETH_HDR_LEN)
+        return false;
+
+    struct netif* netif = netif_from_idx(netif_idx);
+    if (!netif)
+        return false;
+
+    memcpy(macs + 6, netif->hwaddr, 6);
+
+    if (netDump_is_ARP(ethdata))
     {
+        if (size < ETH_HDR_LEN + 28)
+            return false;
         if (netDump_is_ARP_who(ethdata))
         {
-            netDumpMac(out, ethdata + 6);
-            out.print(F(">ff:ff:ff:ff:ff:ff"));
-            return;
+            // lwIP refreshes a stable entry with a unicast request to its
+            // mac first (ARP_AGE_REREQUEST_USED_UNICAST), and broadcasts
+            // only when the host is still silent 15s later (shown unicast too)
+            uint32_t target;
+            memcpy(&target, ethdata + ETH_HDR_LEN + 24, 4);
+            const uint8_t* mac = etharp_mac(target, netif);
+            if (mac)
+                memcpy(macs, mac, 6);
+            else
+                memset(macs, 0xff, 6);
         }
-        else if (netDump_is_ARP_is(ethdata))
-            memcpy(&ip, ethdata + ETH_HDR_LEN + 14, 4);
         else
-        {
-            out.print(F("arpmac?"));
-            return;
-        }
+            // reply: to the target hw address
+            memcpy(macs, ethdata + ETH_HDR_LEN + 18, 6);
+        return true;
     }
-    else
-        out.print(F("mac/proto?"));
-    
-    ip4_addr_t ip4dst;
-    struct eth_addr* eth_ret;
-    struct netif* netif_ret;
-    ip4_addr_t* ip_ret;
 
-    ip4_addr_set_u32(&ip4dst, ip);
+    if (!netDump_is_IPv4(ethdata) || size < ETH_HDR_LEN + 20)
+    {
+        memset(macs, 0, 6);
+        return false;
+    }
 
-    for (int i = 0; etharp_get_entry(i, &ip_ret, &netif_ret, &eth_ret); i++)
-        if (ip_ret->addr == ip4dst.addr)
-        {
-            netDumpMac(out, (const char*)netif_ret->hwaddr);
-            out.print('>');
-            netDumpMac(out, (const char*)eth_ret->addr);
-            return;
-        }
+    const uint8_t* dst = (const uint8_t*)ethdata + ETH_HDR_LEN + 16;
+    uint32_t ip;
+    memcpy(&ip, dst, 4);
+    uint32_t mask = ip4_addr_get_u32(netif_ip4_netmask(netif));
 
-    out.print(F("mac?"));
+    if ((dst[0] & 0xf0) == 0xe0)
+    {
+        // multicast
+        static const uint8_t mcast [] = { 0x01, 0x00, 0x5e };
+        memcpy(macs, mcast, 3);
+        macs[3] = dst[1] & 0x7f;
+        macs[4] = dst[2];
+        macs[5] = dst[3];
+        return true;
+    }
+
+    if (ip == 0xffffffff || (mask && (ip & ~mask) == ~mask))
+    {
+        memset(macs, 0xff, 6);
+        return true;
+    }
+
+    uint32_t local = ip4_addr_get_u32(netif_ip4_addr(netif));
+    if ((ip & mask) != (local & mask))
+        // next hop is the gateway
+        ip = ip4_addr_get_u32(netif_ip4_gw(netif));
+
+    const uint8_t* mac = arp_lookup(ip, netif);
+    if (!mac)
+    {
+        memset(macs, 0, 6);
+        return false;
+    }
+    memcpy(macs, mac, 6);
+    return true;
 }
-#endif
+
+void netDumpMacsForOutput (Print& out, const char* ethdata, size_t size, int netif_idx)
+{
+    char macs [12];
+    bool known = netDumpMacsResolve(macs, ethdata, size, netif_idx, 1);
+    netDumpMac(out, macs + 6);
+    out.print('>');
+    if (known)
+        netDumpMac(out, macs);
+    else
+        out.print(F("mac?"));
+}
+
+#endif // !lwip-v1
 
 void netDumpMacs (Print& out, const char* ethdata)
 {
@@ -21,115 +21,216 @@
 
 #include <ESP8266WiFi.h>
 #include <NetDump.h>
+#include "tcpdump.h"
 #include <lwipopts.h>
 #include <lwip/init.h>
+#include <new>
 
 #if LWIP_VERSION_MAJOR != 1
 
 static WiFiServer tcpdump_server(2); // port will be overwritten
 static WiFiClient tcpdump_client;    // only one allowed
+static WiFiUDP tcpdump_udp;          // or connectionless export
 
 static bool fastsend;
-static size_t snaplen, ptr;
 static char* buf = nullptr;
+static size_t bufsize = 0;
+static size_t snaplen;
 static uint16_t svcport;
+static IPAddress collector;
 
-size_t tcpdump_err = 0;
+static size_t budget = TCPDUMP_BUFFER_MAX;
+static size_t reserve = TCPDUMP_HEAP_RESERVE;
 
-#define BUFSIZE TCP_MSS // one tcp segment max, multiple of 4
+#define DGRAMSIZE TCP_MSS // udp export: one datagram max, multiple of 4
 
-static void dump (int netif_idx, const char* data, size_t len, int out, int success)
+// capture buffer: only allocated while capturing,
+// sized from the budget and the heap left to the others
+
+static size_t buffer_min ()
+{
+    size_t min = 4*4 + snaplen;
+    return min < 24? 24: min;
+}
+
+// what we could have now, counting our current buffer as free
+static size_t buffer_target ()
 {
-    (void)netif_idx;
-    (void)success;
-    
-    if (   netDump_is_IPv4(data)
-        && netDump_is_TCP(data)
-        && (   ( out && netDump_getSrcPort(data) == svcport)
-            || (!out && netDump_getDstPort(data) == svcport)
-           )
-       )
+    size_t size = budget;
+    if (collector && size > DGRAMSIZE)
+        size = DGRAMSIZE;
+    size_t heap = ESP.getFreeHeap() + bufsize;
+    if (heap < reserve + size)
+        size = heap > reserve? heap - reserve: 0;
+    size_t block = ESP.getMaxFreeBlockSize();
+    if (block < bufsize)
+        block = bufsize;
+    if (size > block)
+        size = block;
+    return size & ~3;
+}
+
+static void buffer_free ()
+{
+    tcpdump_buffer(nullptr, 0);
+    if (buf)
+        delete [] buf;
+    buf = nullptr;
+    bufsize = 0;
+}
+
+static bool buffer_alloc (size_t size)
+{
+    buffer_free();
+    if (size < buffer_min())
+        return false;
+    buf = new (std::nothrow) char[size];
+    if (!buf)
+        return false;
+    bufsize = size;
+    tcpdump_buffer(buf, bufsize);
+    return true;
+}
+
+// called when the buffer is empty:
+// shrink under memory pressure, grow back when memory is available again
+// (shrinking waits for target < 3/4 bufsize, the heap under the reserve or a
+// lower budget: a heap moving around the boundary would otherwise reallocate
+// every loop)
+static void buffer_adjust ()
+{
+    size_t target = buffer_target();
+    bool shrink =    target < bufsize
+                  && (   target < bufsize / 4 * 3
+                      || ESP.getFreeHeap() < reserve
+                      || bufsize > budget);
+    if (shrink || (target >= 2 * bufsize && bufsize < budget))
     {
-        // skip myself
-        return;
+        if (target > 2 * bufsize)
+            target = 2 * bufsize;
+        if (target < buffer_min())
+            target = buffer_min();
+        if (target != bufsize)
+            buffer_alloc(target);
     }
-    
-    size_t snap = (len + 3) & ~3;
-    if (snaplen < snap)
-        snap = snaplen;
-    
-    if ((ptr + (4*4) + snap) > BUFSIZE)
+}
+
+// esp backend for the portable core in tcpdump.cpp
+
+static bool esp_accept (void*)
+{
+    if (!tcpdump_server.hasClient())
+        return false;
+    tcpdump_client = tcpdump_server.available();
+    if (!buf && !buffer_alloc(buffer_target()))
     {
-        // no room, lost capture
-        tcpdump_err++;
-        return;
+        // not enough memory
+        tcpdump_client.stop();
+        return false;
     }
+    if (fastsend)
+        tcpdump_client.setNoDelay(true);
+    return true;
+}
+
+static bool esp_connected (void*)
+{
+    return tcpdump_client && tcpdump_client.connected();
+}
 
-    if (!buf || snap <= 0)
-        return;
+static size_t esp_writable (void*)
+{
+    return tcpdump_client? tcpdump_client.availableForWrite(): 0;
+}
+
+static bool esp_send (void*, const char* data, size_t len)
+{
+    if (collector)
+        return    tcpdump_udp.beginPacket(collector, svcport)
+               && tcpdump_udp.write((const uint8_t*)data, len) == len
+               && tcpdump_udp.endPacket();
+    return tcpdump_client.write(data, len) == len;
+}
 
-    // pcap-savefile(5) packet header
+static void esp_now (void*, uint32_t* sec, uint32_t* usec)
+{
     struct timeval tv;
     gettimeofday(&tv, nullptr);
-    *(uint32_t*)&buf[ptr] = tv.tv_sec;
-    *(uint32_t*)&buf[ptr+4] = tv.tv_usec;
-    *(uint32_t*)&buf[ptr+8] = snap;
-    *(uint32_t*)&buf[ptr+12] = len < snap? snap: len;
+    *sec = tv.tv_sec;
+    *usec = tv.tv_usec;
+}
 
-    memcpy(buf + ptr + 4*4, data, snap > len? len: snap);
-    
-    ptr += 4*4 + snap;
+static uint32_t esp_now_ms (void*)
+{
+    return millis();
 }
 
-bool tcpdump_setup (uint16_t port, size_t snap, bool fast)
+static void esp_capture (void*, bool on)
 {
-    if (!buf)
-        buf = new char[BUFSIZE];
+    phy_capture = on? tcpdump_capture: nullptr;
+    if (!on)
+        buffer_free();
+}
 
-    if (buf)
-    {
-        snaplen = (snap + 3) & ~3;
-        fastsend = fast;
-        svcport = port;
-        tcpdump_server.begin(svcport);
-        return true; //!!tcpdump_server;
-    }
+static void esp_fix_macs (void*, char* frame, const char* data, size_t len, int netif_idx, int out)
+{
+    netDumpMacsResolve(frame, data, len, netif_idx, out);
+}
 
-    if (buf)
-      delete [] buf;
-    buf = nullptr;
-    return false;
+static const tcpdump_ops esp_ops =
+{
+    esp_accept,
+    esp_connected,
+    esp_writable,
+    esp_send,
+    esp_now,
+    esp_now_ms,
+    esp_capture,
+    esp_fix_macs,
+};
+
+void tcpdump_memory (size_t max, size_t heap_reserve)
+{
+    budget = max & ~3;
+    reserve = heap_reserve;
+}
+
+size_t tcpdump_buffer_size ()
+{
+    return bufsize;
+}
+
+bool tcpdump_setup (uint16_t port, size_t snap, bool fast)
+{
+    // the buffer is allocated when a client connects
+    buffer_free();
+    fastsend = fast;
+    svcport = port;
+    snaplen = (snap + 3) & ~3;
+    collector = IPAddress();
+    tcpdump_begin(&esp_ops, nullptr, nullptr, 0, snap, svcport, 0);
+    tcpdump_server.begin(svcport);
+    return true; //!!tcpdump_server;
+}
+
+bool tcpdump_udp_setup (const IPAddress& to, uint16_t port, size_t snap)
+{
+    buffer_free();
+    svcport = port;
+    snaplen = (snap + 3) & ~3;
+    collector = to;
+    if (!buffer_alloc(buffer_target()))
+        return false;
+    tcpdump_begin(&esp_ops, nullptr, buf, bufsize, snap, svcport, (uint32_t)to);
+    return true;
 }
 
 void tcpdump_loop ()
 {
-    if (tcpdump_server.hasClient())
-    {
-        tcpdump_client = tcpdump_server.available();
-        if (fastsend)
-            tcpdump_client.setNoDelay(true);
-
-        // pcap-savefile(5) capture preamble
-        *(uint32_t*)&buf[0] = 0xa1b2c3d4;
-        *(uint32_t*)&buf[4] = 0x00040002;
-        *(uint32_t*)&buf[8] = 0;
-        *(uint32_t*)&buf[12] = 0;
-        *(uint32_t*)&buf[16] = snaplen;
-        *(uint32_t*)&buf[20] = 1;
-        tcpdump_client.write(buf, 24);
-
-        ptr = 0;
-        phy_capture = dump;
-    }
-    
-    if (!tcpdump_client || !tcpdump_client.connected())
-        phy_capture = nullptr;
-   
-    if (ptr && tcpdump_client && tcpdump_client.availableForWrite() >= ptr)
-    {
-        tcpdump_client.write(buf, ptr);
-        ptr = 0;
-    }
+    tcpdump_poll();
+    if (phy_capture == tcpdump_capture && !tcpdump_buffered())
+        // also retries after a failed allocation
+        buffer_adjust();
 }
 
-#endif // !lwip-v1
\ No newline at end of file
+#endif // !lwip-v1
@@ -0,0 +1,333 @@
+/*
+ NetDump library - tcpdump-like packet logger facility
+
+ Copyright (c) 2018 David Gauchard. All rights reserved.
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <ESP8266WiFi.h>
+#include <NetDump.h>
+#include <lwip/init.h>
+#include <new>
+
+#if LWIP_VERSION_MAJOR != 1
+
+#include <lwip/netif.h>
+#include <lwip/pbuf.h>
+
+// pcap replay: records (pcap-savefile(5), as sent by the tcpdump server)
+// are read from a Stream and given to the netif input path as if received
+
+#define REPLAY_FRAME 1536   // largest frame replayed
+
+static WiFiServer replay_server(3); // port will be overwritten
+static WiFiClient replay_client;
+static bool replay_serving = false;
+
+static Stream* in = nullptr;
+static char* frame = nullptr;
+static size_t got;              // bytes of the current preamble/record in frame
+static bool preamble;           // still reading the 24 bytes file header
+static bool nanosec;            // timestamps in ns
+static float speed;
+static int netif_idx;
+
+// timing: capture time of the first record <-> local time when it was injected
+static bool started;
+static uint64_t first_cap_us;
+static uint32_t first_us;
+
+// address rewrite: the captured device's ip is replaced by ours
+static uint32_t captured_ip;
+
+netdump_replay_stats netdump_replay;
+
+static struct netif* replay_netif ()
+{
+    for (struct netif* netif = netif_list; netif; netif = netif->next)
+        if (netif->num == netif_idx)
+            return netif;
+    return nullptr;
+}
+
+// rfc1624 incremental update of a ones' complement sum (network order)
+static void csum_replace (char* sum, uint32_t from, uint32_t to)
+{
+    const uint8_t* f = (const uint8_t*)&from;
+    const uint8_t* t = (const uint8_t*)&to;
+    uint32_t s = (uint16_t)~(((uint8_t)sum[0] << 8) | (uint8_t)sum[1]);
+    for (int i = 0; i < 4; i += 2)
+    {
+        s += (uint16_t)~((f[i] << 8) | f[i + 1]);
+        s += (t[i] << 8) | t[i + 1];
+    }
+    while (s >> 16)
+        s = (s & 0xffff) + (s >> 16);
+    s = (uint16_t)~s;
+    sum[0] = s >> 8;
+    sum[1] = s;
+}
+
+// arp: requests and replies to the captured device are rewritten
+static bool rewrite_arp (char* data, size_t len, struct netif* netif)
+{
+    if (len < ETH_HDR_LEN + 28)
+        return false;
+
+    uint32_t sender, target;
+    memcpy(&sender, data + ETH_HDR_LEN + 14, 4);
+    memcpy(&target, data + ETH_HDR_LEN + 24, 4);
+    if (sender == captured_ip)
+        // sent by the captured device
+        return false;
+
+    if (target == captured_ip)
+    {
+        uint32_t ip = ip4_addr_get_u32(netif_ip4_addr(netif));
+        memcpy(data + ETH_HDR_LEN + 24, &ip, 4);
+        if (netDump_is_ARP_is(data))
+            memcpy(data + ETH_HDR_LEN + 18, netif->hwaddr, 6);
+        if (!(data[0] & 1))
+            memcpy(data, netif->hwaddr, 6);
+    }
+    // else: broadcast request for another host, as captured
+    return true;
+}
+
+// false: not to be injected
+static bool rewrite (char* data, size_t len, struct netif* netif)
+{
+    if (len < ETH_HDR_LEN)
+        return false;
+    if (netDump_is_ARP(data))
+        return rewrite_arp(data, len, netif);
+    if (!netDump_is_IPv4(data) || len < ETH_HDR_LEN + 20)
+        // ipv6 and others are not rewritten, so not replayed
+        return false;
+
+    uint32_t src, dst;
+    memcpy(&src, data + ETH_HDR_LEN + 12, 4);
+    memcpy(&dst, data + ETH_HDR_LEN + 16, 4);
+
+    if (src == captured_ip)
+        // sent by the captured device
+        return false;
+
+    if (dst == captured_ip && !(data[0] & 1))
+    {
+        memcpy(data, netif->hwaddr, 6);
+        uint32_t ip = ip4_addr_get_u32(netif_ip4_addr(netif));
+        memcpy(data + ETH_HDR_LEN + 16, &ip, 4);
+        csum_replace(data + ETH_HDR_LEN + 10, dst, ip);
+
+        size_t l4 = ETH_HDR_LEN + netDump_getIpHdrLen(data);
+        if (netDump_is_TCP(data) && len >= l4 + 18)
+            csum_replace(data + l4 + 16, dst, ip);
+        else if (netDump_is_UDP(data) && len >= l4 + 8 && (data[l4 + 6] || data[l4 + 7]))
+            csum_replace(data + l4 + 6, dst, ip);
+    }
+    return true;
+}
+
+static void inject (char* data, size_t len)
+{
+    struct netif* netif = replay_netif();
+    if (!netif || !rewrite(data, len, netif))
+    {
+        netdump_replay.skipped++;
+        return;
+    }
+
+    struct pbuf* p = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+    if (!p)
+    {
+        netdump_replay.drops++;
+        return;
+    }
+    memcpy(p->payload, data, len);
+    if (netif->input(p, netif) != ERR_OK)
+    {
+        pbuf_free(p);
+        netdump_replay.drops++;
+        return;
+    }
+    netdump_replay.packets++;
+    netdump_replay.bytes += len;
+
+    uint32_t heap = ESP.getFreeHeap();
+    if (heap < netdump_replay.heap_min)
+        netdump_replay.heap_min = heap;
+}
+
+bool netDumpReplay (Stream* from, float replay_speed, int netif)
+{
+    memset(&netdump_replay, 0, sizeof(netdump_replay));
+    if (!captured_ip)
+    {
+        // which frames were sent by the device cannot be told reliably
+        netdump_replay.done = true;
+        return false;
+    }
+    if (!frame)
+        frame = new (std::nothrow) char[16 + REPLAY_FRAME];
+    in = frame? from: nullptr;
+    speed = replay_speed;
+    netif_idx = netif;
+    got = 0;
+    preamble = true;
+    started = false;
+    netdump_replay.heap_min = ESP.getFreeHeap();
+    return in != nullptr;
+}
+
+void netDumpReplayDevice (uint32_t ip)
+{
+    captured_ip = ip;
+}
+
+bool netDumpReplaySetup (uint16_t port, float replay_speed, int netif)
+{
+    if (!captured_ip)
+        return false;
+    speed = replay_speed;
+    netif_idx = netif;
+    replay_server.begin(port);
+    replay_serving = true;
+    return true;
+}
+
+static void replay_end ()
+{
+    if (started)
+        netdump_replay.duration_ms = (micros() - first_us) / 1000;
+    netdump_replay.done = true;
+    in = nullptr;
+    delete [] frame;
+    frame = nullptr;
+}
+
+void netDumpReplayLoop ()
+{
+    if (replay_serving && replay_server.hasClient())
+    {
+        replay_client = replay_server.available();
+        netDumpReplay(&replay_client, speed, netif_idx);
+    }
+
+    if (!in)
+        return;
+
+    for (int records = 0; records < NETDUMP_REPLAY_BURST; )
+    {
+        size_t need = preamble? 24: got < 16? 16: 16 + *(uint32_t*)&frame[8];
+        // never wait for data
+        int avail;
+        while (got < need && (avail = in->available()) > 0)
+        {
+            size_t want = need - got;
+            if (want > (size_t)avail)
+                want = avail;
+            int n = in->read((uint8_t*)frame + got, want);
+            if (n <= 0)
+                break;
+            got += n;
+        }
+
+        if (got < need)
+        {
+            if (in == &replay_client && !replay_client.connected() && !replay_client.available())
+                replay_end();
+            else if (in != &replay_client && in->available() <= 0)
+                // file or memory stream: end of data
+                replay_end();
+            return;
+        }
+
+        if (preamble)
+        {
+            uint32_t magic = *(uint32_t*)&frame[0];
+            if (magic != 0xa1b2c3d4 && magic != 0xa1b23c4d)
+            {
+                // not a little-endian pcap stream
+                replay_end();
+                return;
+            }
+            nanosec = magic == 0xa1b23c4d;
+            preamble = false;
+            got = 0;
+            continue;
+        }
+
+        uint32_t caplen = *(uint32_t*)&frame[8];
+        uint32_t len = *(uint32_t*)&frame[12];
+        if (got == 16)
+        {
+            if (caplen > REPLAY_FRAME)
+            {
+                replay_end();
+                return;
+            }
+            if (caplen)
+                // read the frame
+                continue;
+        }
+
+        // timing
+        uint64_t cap_us = *(uint32_t*)&frame[0] * 1000000ULL
+                        + (nanosec? *(uint32_t*)&frame[4] / 1000: *(uint32_t*)&frame[4]);
+        if (!started)
+        {
+            started = true;
+            first_cap_us = cap_us;
+            first_us = micros();
+        }
+        else if (speed > 0)
+        {
+            uint32_t due = (uint32_t)((cap_us - first_cap_us) / speed);
+            if ((int32_t)(micros() - first_us - due) < 0)
+                // not yet
+                return;
+        }
+
+        if (caplen < len)
+            // snapped by the capture, cannot be injected
+            netdump_replay.truncated++;
+        else
+            inject(frame + 16, caplen);
+        got = 0;
+        // with no wait (speed 0), the rest is for the next call
+        records++;
+    }
+}
+
+void netDumpReplayPrint (Print& out)
+{
+    uint32_t ms = netdump_replay.done || !started? netdump_replay.duration_ms: (micros() - first_us) / 1000;
+    out.printf("replay: %u packets %u bytes in %u ms (%u pkt/s, %u B/s) drops:%u skipped:%u truncated:%u heap-min:%u%s\r\n",
+        (unsigned)netdump_replay.packets,
+        (unsigned)netdump_replay.bytes,
+        (unsigned)ms,
+        ms? (unsigned)(netdump_replay.packets * 1000ULL / ms): 0,
+        ms? (unsigned)(netdump_replay.bytes * 1000ULL / ms): 0,
+        (unsigned)netdump_replay.drops,
+        (unsigned)netdump_replay.skipped,
+        (unsigned)netdump_replay.truncated,
+        (unsigned)netdump_replay.heap_min,
+        netdump_replay.done? " (done)": "");
+}
+
+#endif // !lwip-v1
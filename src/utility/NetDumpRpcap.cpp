@@ -0,0 +1,484 @@
+/*
+ NetDump library - tcpdump-like packet logger facility
+
+ Copyright (c) 2018 David Gauchard. All rights reserved.
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <ESP8266WiFi.h>
+#include <NetDump.h>
+#include <lwipopts.h>
+#include <lwip/init.h>
+#include <new>
+
+#if LWIP_VERSION_MAJOR != 1
+
+#include "bpf.h"
+
+// rpcap (libpcap remote capture protocol, version 0), passive tcp mode only:
+// control connection on port, packets sent on a data connection to data_port
+// filters given by the client are run here before packets are copied
+// all fields are big endian
+
+#define RPCAP_MAX_MSG       1024    // largest control message payload
+#define RPCAP_MAX_INSNS     ((RPCAP_MAX_MSG - 8) / 8)
+#define RPCAP_SNAPLEN       1514
+#define RPCAP_BUFSIZE       (2 * TCP_MSS)
+
+// messages
+#define MSG_ERROR           1
+#define MSG_FINDALLIF       2
+#define MSG_OPEN            3
+#define MSG_STARTCAP        4
+#define MSG_UPDATEFILTER    5
+#define MSG_CLOSE           6
+#define MSG_PACKET          7
+#define MSG_AUTH            8
+#define MSG_STATS           9
+#define MSG_ENDCAP          10
+#define MSG_SETSAMPLING     11
+#define MSG_REPLY           0x80
+
+// error codes
+#define ERR_AUTH            3
+#define ERR_UPDATEFILTER    7
+#define ERR_STARTCAPTURE    12
+#define ERR_SETSAMPLING     15
+#define ERR_WRONGMSG        16
+#define ERR_WRONGVER        17
+
+// startcap flags
+#define FLAG_DGRAM          2
+#define FLAG_SERVEROPEN     4
+#define FLAG_INBOUND        8
+#define FLAG_OUTBOUND       16
+
+// sampling methods
+#define SAMP_1_EVERY_N      1
+#define SAMP_FIRST_AFTER_MS 2
+
+#define HDR 8               // message header
+#define PKTHDR 20           // packet header (ts, caplen, len, npkt)
+
+static WiFiServer rpcap_server(RPCAP_PORT);          // ports will be overwritten
+static WiFiServer rpcap_data_server(RPCAP_DATA_PORT);
+static WiFiClient ctrl;
+static WiFiClient data;
+static uint16_t ctrl_port, data_port;
+
+static char* msg = nullptr;     // control message being received
+static size_t msg_got;
+static uint32_t msg_skip;       // payload bytes of a rejected message still to discard
+
+static bpf_insn* filter = nullptr;
+static uint32_t snaplen;
+static uint16_t directions;
+static uint8_t sampling;
+static uint32_t sampling_value, sampling_count, sampling_ms;
+
+static char* buf = nullptr;
+static size_t ptr;
+static bool started;
+
+rpcap_stats rpcap;
+
+static void put16 (char* p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v;
+}
+
+static void put32 (char* p, uint32_t v)
+{
+    put16(p, v >> 16);
+    put16(p + 2, v);
+}
+
+static uint16_t get16 (const char* p)
+{
+    return ((uint8_t)p[0] << 8) | (uint8_t)p[1];
+}
+
+static uint32_t get32 (const char* p)
+{
+    return ((uint32_t)get16(p) << 16) | get16(p + 2);
+}
+
+static void header (char* h, uint8_t type, uint16_t value, uint32_t plen)
+{
+    h[0] = 0;   // version
+    h[1] = type;
+    put16(h + 2, value);
+    put32(h + 4, plen);
+}
+
+static void reply (uint8_t type, uint16_t value, const char* payload, uint32_t plen)
+{
+    char h [HDR];
+    header(h, type | MSG_REPLY, value, plen);
+    ctrl.write(h, HDR);
+    if (plen)
+        ctrl.write(payload, plen);
+}
+
+static void reply_error (uint16_t code, const char* text)
+{
+    char h [HDR];
+    header(h, MSG_ERROR, code, strlen(text));
+    ctrl.write(h, HDR);
+    ctrl.write(text, strlen(text));
+}
+
+static void capture (int netif_idx, const char* ethdata, size_t len, int out, int success)
+{
+    (void)netif_idx;
+    (void)success;
+
+    if (   netDump_is_IPv4(ethdata)
+        && netDump_is_TCP(ethdata))
+    {
+        uint16_t port = out? netDump_getSrcPort(ethdata): netDump_getDstPort(ethdata);
+        if (port == ctrl_port || port == data_port)
+            // skip myself
+            return;
+    }
+
+    if (!(directions & (out? FLAG_OUTBOUND: FLAG_INBOUND)))
+        return;
+
+    rpcap.received++;
+
+    uint32_t caplen = filter? bpf_run(filter, (const uint8_t*)ethdata, len, len): len;
+    if (!caplen)
+    {
+        rpcap.filtered++;
+        return;
+    }
+
+    // sampling applies to the packets the filter accepted
+    if (sampling == SAMP_1_EVERY_N && sampling_value > 1 && ++sampling_count % sampling_value)
+        return;
+    if (sampling == SAMP_FIRST_AFTER_MS)
+    {
+        uint32_t now = millis();
+        if (now - sampling_ms < sampling_value)
+            return;
+        sampling_ms = now;
+    }
+    if (caplen > snaplen)
+        caplen = snaplen;
+    if (caplen > len)
+        caplen = len;
+
+    if (!buf || ptr + HDR + PKTHDR + caplen > RPCAP_BUFSIZE)
+    {
+        // no room, lost capture
+        rpcap.dropped++;
+        return;
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    char* p = buf + ptr;
+    header(p, MSG_PACKET, 0, PKTHDR + caplen);
+    put32(p + HDR, tv.tv_sec);
+    put32(p + HDR + 4, tv.tv_usec);
+    put32(p + HDR + 8, caplen);
+    put32(p + HDR + 12, len);
+    put32(p + HDR + 16, ++rpcap.captured);
+    memcpy(p + HDR + PKTHDR, ethdata, caplen);
+    ptr += HDR + PKTHDR + caplen;
+}
+
+// rpcap_filter: type, dummy, count, bpf instructions
+static bool set_filter (const char* payload, uint32_t plen)
+{
+    if (plen < 8 || get16(payload) != 1 /* bpf */)
+        return false;
+    uint32_t count = get32(payload + 4);
+    if (count > RPCAP_MAX_INSNS || plen < 8 + count * 8)
+        return false;
+
+    bpf_insn* prog = new (std::nothrow) bpf_insn[count];
+    if (!prog)
+        return false;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const char* insn = payload + 8 + i * 8;
+        prog[i].code = get16(insn);
+        prog[i].jt = insn[2];
+        prog[i].jf = insn[3];
+        prog[i].k = get32(insn + 4);
+    }
+    if (!bpf_check(prog, count))
+    {
+        delete [] prog;
+        return false;
+    }
+
+    if (filter)
+        delete [] filter;
+    filter = prog;
+    return true;
+}
+
+static void stop_capture ()
+{
+    if (phy_capture == capture)
+        phy_capture = nullptr;
+    data.stop();
+    started = false;
+    if (buf)
+        delete [] buf;
+    buf = nullptr;
+    ptr = 0;
+    if (filter)
+        delete [] filter;
+    filter = nullptr;
+}
+
+static void stop_control ()
+{
+    stop_capture();
+    ctrl.stop();
+    if (msg)
+        delete [] msg;
+    msg = nullptr;
+}
+
+static void handle (uint8_t type, const char* payload, uint32_t plen)
+{
+    switch (type)
+    {
+    case MSG_AUTH:
+        if (plen < 2 || get16(payload) != 0)
+            reply_error(ERR_AUTH, "null authentication only");
+        else
+            reply(MSG_AUTH, 0, nullptr, 0);
+        break;
+
+    case MSG_FINDALLIF:
+    {
+        // one interface, all netifs
+        static const char name [] = "esp8266";
+        static const char desc [] = "esp8266 (all interfaces)";
+        char p [12 + sizeof(name) - 1 + sizeof(desc) - 1];
+        put16(p, sizeof(name) - 1);
+        put16(p + 2, sizeof(desc) - 1);
+        put32(p + 4, 0);    // flags
+        put16(p + 8, 0);    // addresses
+        put16(p + 10, 0);
+        memcpy(p + 12, name, sizeof(name) - 1);
+        memcpy(p + 12 + sizeof(name) - 1, desc, sizeof(desc) - 1);
+        reply(MSG_FINDALLIF, 1, p, sizeof(p));
+        break;
+    }
+
+    case MSG_OPEN:
+    {
+        char p [8];
+        put32(p, 1);        // ethernet
+        put32(p + 4, 0);    // timezone offset
+        reply(MSG_OPEN, 0, p, sizeof(p));
+        break;
+    }
+
+    case MSG_STARTCAP:
+    {
+        if (plen < 12)
+        {
+            reply_error(ERR_STARTCAPTURE, "short request");
+            break;
+        }
+        uint16_t flags = get16(payload + 8);
+        if (flags & (FLAG_DGRAM | FLAG_SERVEROPEN))
+        {
+            reply_error(ERR_STARTCAPTURE, "passive tcp mode only");
+            break;
+        }
+        stop_capture();
+        if (plen > 12 && !set_filter(payload + 12, plen - 12))
+        {
+            reply_error(ERR_STARTCAPTURE, "bad filter");
+            break;
+        }
+        buf = new (std::nothrow) char[RPCAP_BUFSIZE];
+        if (!buf)
+        {
+            reply_error(ERR_STARTCAPTURE, "no memory");
+            break;
+        }
+        snaplen = get32(payload);
+        if (!snaplen || snaplen > RPCAP_SNAPLEN)
+            snaplen = RPCAP_SNAPLEN;
+        directions = flags & (FLAG_INBOUND | FLAG_OUTBOUND);
+        if (!directions)
+            directions = FLAG_INBOUND | FLAG_OUTBOUND;
+        started = true;
+
+        char p [8];
+        put32(p, RPCAP_BUFSIZE);
+        put16(p + 4, data_port);
+        put16(p + 6, 0);
+        reply(MSG_STARTCAP, 0, p, sizeof(p));
+        break;
+    }
+
+    case MSG_UPDATEFILTER:
+        if (set_filter(payload, plen))
+            reply(MSG_UPDATEFILTER, 0, nullptr, 0);
+        else
+            reply_error(ERR_UPDATEFILTER, "bad filter");
+        break;
+
+    case MSG_SETSAMPLING:
+        if (plen < 8 || (uint8_t)payload[0] > SAMP_FIRST_AFTER_MS)
+        {
+            reply_error(ERR_SETSAMPLING, "bad sampling");
+            break;
+        }
+        sampling = payload[0];
+        sampling_value = get32(payload + 4);
+        sampling_count = 0;
+        sampling_ms = millis() - sampling_value;
+        reply(MSG_SETSAMPLING, 0, nullptr, 0);
+        break;
+
+    case MSG_STATS:
+    {
+        char p [16];
+        put32(p, rpcap.received);
+        put32(p + 4, rpcap.dropped);
+        put32(p + 8, 0);
+        put32(p + 12, rpcap.captured);
+        reply(MSG_STATS, 0, p, sizeof(p));
+        break;
+    }
+
+    case MSG_ENDCAP:
+        stop_capture();
+        reply(MSG_ENDCAP, 0, nullptr, 0);
+        break;
+
+    case MSG_CLOSE:
+        stop_control();
+        break;
+
+    default:
+        reply_error(ERR_WRONGMSG, "unsupported message");
+    }
+}
+
+bool rpcap_setup (uint16_t port, uint16_t dport)
+{
+    ctrl_port = port;
+    data_port = dport;
+    rpcap_server.begin(ctrl_port);
+    rpcap_data_server.begin(data_port);
+    return true;
+}
+
+void rpcap_loop ()
+{
+    if (rpcap_server.hasClient())
+    {
+        // one analyst at a time, the newest one
+        stop_control();
+        ctrl = rpcap_server.available();
+        msg = new (std::nothrow) char[HDR + RPCAP_MAX_MSG];
+        msg_got = 0;
+        msg_skip = 0;
+        sampling = 0;
+        memset(&rpcap, 0, sizeof(rpcap));
+        if (!msg)
+            ctrl.stop();
+    }
+
+    if (msg && !ctrl.connected() && !ctrl.available())
+        stop_control();
+
+    while (msg && msg_skip && ctrl.available() > 0)
+    {
+        // drain an oversized message, the session goes on with the next one
+        int got = ctrl.read((uint8_t*)msg, msg_skip < HDR + RPCAP_MAX_MSG? msg_skip: HDR + RPCAP_MAX_MSG);
+        if (got <= 0)
+            break;
+        msg_skip -= got;
+    }
+
+    while (msg && !msg_skip && ctrl.available() > 0)
+    {
+        size_t need = msg_got < HDR? HDR: HDR + get32(msg + 4);
+        int got = ctrl.read((uint8_t*)msg + msg_got, need - msg_got);
+        if (got <= 0)
+            break;
+        msg_got += got;
+        if (msg_got == HDR)
+        {
+            if (msg[0] != 0)
+            {
+                reply_error(ERR_WRONGVER, "version 0 only");
+                stop_control();
+                break;
+            }
+            if (get32(msg + 4) > RPCAP_MAX_MSG)
+            {
+                // a filter longer than RPCAP_MAX_INSNS is the usual cause
+                if (msg[1] == MSG_STARTCAP)
+                    reply_error(ERR_STARTCAPTURE, "filter too large");
+                else if (msg[1] == MSG_UPDATEFILTER)
+                    reply_error(ERR_UPDATEFILTER, "filter too large");
+                else
+                    reply_error(ERR_WRONGMSG, "message too large");
+                msg_skip = get32(msg + 4);
+                msg_got = 0;
+                break;
+            }
+        }
+        if (msg_got >= HDR && msg_got == HDR + get32(msg + 4))
+        {
+            msg_got = 0;
+            handle(msg[1], msg + HDR, get32(msg + 4));
+        }
+    }
+
+    if (started && rpcap_data_server.hasClient())
+    {
+        data = rpcap_data_server.available();
+        data.setNoDelay(true);
+        ptr = 0;
+        phy_capture = capture;
+    }
+
+    if (phy_capture == capture && !data.connected())
+        stop_capture();
+
+    if (ptr && data)
+    {
+        size_t len = data.availableForWrite();
+        if (len > ptr)
+            len = ptr;
+        if (len)
+        {
+            data.write(buf, len);
+            memmove(buf, buf + len, ptr - len);
+            ptr -= len;
+        }
+    }
+}
+
+#endif // !lwip-v1
@@ -0,0 +1,209 @@
+/*
+ NetDump library - tcpdump-like packet logger facility
+
+ Copyright (c) 2018 David Gauchard. All rights reserved.
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+#include <NetDump.h>
+
+// what makes two packets "the same line"
+struct summary_key
+{
+    uint16_t ethtype;
+    uint8_t  out;
+    uint8_t  netif;
+    uint8_t  proto;     // ip protocol
+    uint8_t  type;      // arp operation, icmp type, tcp flags
+    uint16_t sport;
+    uint16_t dport;
+    uint16_t pad;
+    uint32_t src;       // ip, or arp target
+    uint32_t dst;
+};
+
+struct summary_entry
+{
+    summary_key key;
+    uint32_t hash;
+    uint32_t first_ms;  // when printed
+    uint32_t last_ms;
+    uint32_t count;     // suppressed since
+};
+
+// most recently used first
+static summary_entry lru[NETDUMP_SUMMARY_LRU];
+static int used = 0;
+
+static uint32_t summary_get32 (const char* data)
+{
+    uint32_t v;
+    memcpy(&v, data, 4);
+    return v;
+}
+
+static void summary_make_key (summary_key* key, const char* ethdata, size_t size, int netif_idx, int out)
+{
+    memset(key, 0, sizeof(*key));
+    key->out = out;
+    key->netif = netif_idx;
+    key->ethtype = netDump_ethtype(ethdata);
+
+    if (netDump_is_ARP(ethdata) && size >= ETH_HDR_LEN + 28)
+    {
+        key->type = netDump_getARPType(ethdata);
+        key->src = summary_get32(ethdata + ETH_HDR_LEN + 14);
+        key->dst = summary_get32(ethdata + ETH_HDR_LEN + 24);
+    }
+    else if (netDump_is_IPv4(ethdata) && size >= ETH_HDR_LEN + 20)
+    {
+        key->proto = netDump_getIpType(ethdata);
+        key->src = summary_get32(ethdata + ETH_HDR_LEN + 12);
+        key->dst = summary_get32(ethdata + ETH_HDR_LEN + 16);
+        size_t l4 = ETH_HDR_LEN + netDump_getIpHdrLen(ethdata);
+        if ((netDump_is_TCP(ethdata) || netDump_is_UDP(ethdata)) && size >= l4 + 4)
+        {
+            key->sport = netDump_getSrcPort(ethdata);
+            key->dport = netDump_getDstPort(ethdata);
+        }
+        if (netDump_is_TCP(ethdata) && size >= l4 + 14)
+            key->type = netDump_getTcpFlags(ethdata);
+        else if (netDump_is_ICMP(ethdata) && size > l4)
+            key->type = ethdata[l4];
+    }
+}
+
+static uint32_t summary_hash (const summary_key* key)
+{
+    // FNV-1a
+    const uint8_t* data = (const uint8_t*)key;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(*key); i++)
+        hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+static void summary_print (Print& out, const summary_entry* e)
+{
+    const summary_key* k = &e->key;
+    uint32_t ms = e->last_ms - e->first_ms;
+    uint32_t rate10 = ms? (uint64_t)e->count * 10000 / ms: 0;
+
+    out.printf("%s %d  last message repeated %u times in %u.%us (%u.%u/s):",
+        k->out? "out": " in", k->netif,
+        (unsigned)e->count, (unsigned)(ms / 1000), (unsigned)(ms % 1000 / 100),
+        (unsigned)(rate10 / 10), (unsigned)(rate10 % 10));
+
+    if (k->ethtype == 0x0806)
+    {
+        if (k->type == 1)
+        {
+            out.print(F(" ARP who has "));
+            netDumpIPv4(out, (const char*)&k->dst);
+            out.print(F(" tell "));
+            netDumpIPv4(out, (const char*)&k->src);
+        }
+        else
+        {
+            out.print(F(" ARP "));
+            netDumpIPv4(out, (const char*)&k->src);
+            out.print(F(" reply to "));
+            netDumpIPv4(out, (const char*)&k->dst);
+        }
+    }
+    else if (k->ethtype == 0x0800)
+    {
+        out.print(F(" IPv4 "));
+        netDumpIPv4(out, (const char*)&k->src);
+        out.print('>');
+        netDumpIPv4(out, (const char*)&k->dst);
+        switch (k->proto)
+        {
+        case 1:  out.printf(" ICMP type(%u)", k->type); break;
+        case 2:  out.print(F(" IGMP")); break;
+        case 6:  out.printf(" TCP %u>%u flags(0x%02x)", k->sport, k->dport, k->type); break;
+        case 17: out.printf(" UDP %u>%u", k->sport, k->dport); break;
+        default: out.printf(" ip proto 0x%02x", k->proto);
+        }
+    }
+    else
+        out.printf(" eth proto 0x%04x", k->ethtype);
+    out.println();
+}
+
+static void summary_use (int i)
+{
+    // move to front
+    summary_entry e = lru[i];
+    memmove(&lru[1], &lru[0], i * sizeof(lru[0]));
+    lru[0] = e;
+}
+
+bool netDumpSummary (Print& out, const char* ethdata, size_t size, int netif_idx, int out_dir)
+{
+    if (size < ETH_HDR_LEN)
+        return true;
+
+    summary_key key;
+    summary_make_key(&key, ethdata, size, netif_idx, out_dir);
+    uint32_t hash = summary_hash(&key);
+    uint32_t now = millis();
+
+    for (int i = 0; i < used; i++)
+        if (lru[i].hash == hash && !memcmp(&lru[i].key, &key, sizeof(key)))
+        {
+            summary_use(i);
+            summary_entry* e = &lru[0];
+            if (now - e->first_ms < NETDUMP_SUMMARY_WINDOW)
+            {
+                e->count++;
+                e->last_ms = now;
+                return false;
+            }
+            // window is over, print this one again
+            if (e->count)
+                summary_print(out, e);
+            e->first_ms = e->last_ms = now;
+            e->count = 0;
+            return true;
+        }
+
+    // new line, evicts the least recently used
+    if (used < NETDUMP_SUMMARY_LRU)
+        used++;
+    else if (lru[used - 1].count)
+        summary_print(out, &lru[used - 1]);
+    summary_use(used - 1);
+    lru[0].key = key;
+    lru[0].hash = hash;
+    lru[0].first_ms = lru[0].last_ms = now;
+    lru[0].count = 0;
+    return true;
+}
+
+void netDumpSummaryFlush (Print& out)
+{
+    uint32_t now = millis();
+    for (int i = 0; i < used; i++)
+        if (lru[i].count && now - lru[i].first_ms >= NETDUMP_SUMMARY_WINDOW)
+        {
+            summary_print(out, &lru[i]);
+            lru[i].count = 0;
+            lru[i].first_ms = lru[i].last_ms = now;
+        }
+}
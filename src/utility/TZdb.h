@@ -0,0 +1,1043 @@
+
+// autogenerated by TZupdate from TZ.h
+// names are TZ.h names without TZ_, sorted (C locale)
+
+#ifndef TZDB_POOL_H
+#define TZDB_POOL_H
+
+#define TZDB_ZONES 460
+
+static const char tzdb_rules [] PROGMEM =
+    "GMT0" "\0"
+    "EAT-3" "\0"
+    "CET-1" "\0"
+    "WAT-1" "\0"
+    "CAT-2" "\0"
+    "EET-2" "\0"
+    "WET0WEST,M3.5.0,M10.5.0/3" "\0"
+    "CET-1CEST,M3.5.0,M10.5.0/3" "\0"
+    "SAST-2" "\0"
+    "HST10HDT,M3.2.0,M11.1.0" "\0"
+    "AKST9AKDT,M3.2.0,M11.1.0" "\0"
+    "AST4" "\0"
+    "<-03>3" "\0"
+    "<-04>4<-03>,M10.1.0/0,M3.4.0/0" "\0"
+    "EST5" "\0"
+    "CST6CDT,M4.1.0,M10.5.0" "\0"
+    "CST6" "\0"
+    "<-04>4" "\0"
+    "<-05>5" "\0"
+    "MST7MDT,M3.2.0,M11.1.0" "\0"
+    "<-04>4<-03>,M11.1.0/0,M2.3.0/0" "\0"
+    "CST6CDT,M3.2.0,M11.1.0" "\0"
+    "MST7MDT,M4.1.0,M10.5.0" "\0"
+    "MST7" "\0"
+    "PST8PDT,M3.2.0,M11.1.0" "\0"
+    "EST5EDT,M3.2.0,M11.1.0" "\0"
+    "AST4ADT,M3.2.0,M11.1.0" "\0"
+    "<-03>3<-02>,M3.5.0/-2,M10.5.0/-1" "\0"
+    "CST5CDT,M3.2.0/0,M11.1.0/1" "\0"
+    "<-03>3<-02>,M3.2.0,M11.1.0" "\0"
+    "<-02>2" "\0"
+    "<-04>4<-03>,M8.2.6/24,M5.2.6/24" "\0"
+    "<-03>3<-02>,M11.1.0/0,M2.3.0/0" "\0"
+    "<-01>1<+00>,M3.5.0/0,M10.5.0/1" "\0"
+    "NST3:30NDT,M3.2.0,M11.1.0" "\0"
+    "<+08>-8" "\0"
+    "<+07>-7" "\0"
+    "<+10>-10" "\0"
+    "<+11>-11" "\0"
+    "<+05>-5" "\0"
+    "NZST-12NZDT,M9.5.0,M4.1.0/3" "\0"
+    "<+03>-3" "\0"
+    "<+00>0<+02>-2,M3.5.0/1,M10.5.0/3" "\0"
+    "<+06>-6" "\0"
+    "EET-2EEST,M3.5.4/24,M10.5.5/1" "\0"
+    "<+12>-12" "\0"
+    "<+04>-4" "\0"
+    "EET-2EEST,M3.5.0/0,M10.5.0/0" "\0"
+    "<+09>-9" "\0"
+    "<+0530>-5:30" "\0"
+    "EET-2EEST,M3.5.5/0,M10.5.5/0" "\0"
+    "EET-2EEST,M3.5.0/3,M10.5.0/4" "\0"
+    "EET-2EEST,M3.4.6/1,M10.5.6/1" "\0"
+    "HKT-8" "\0"
+    "WIB-7" "\0"
+    "WIT-9" "\0"
+    "IST-2IDT,M3.4.4/26,M10.5.0" "\0"
+    "<+0430>-4:30" "\0"
+    "PKT-5" "\0"
+    "<+0545>-5:45" "\0"
+    "IST-5:30" "\0"
+    "CST-8" "\0"
+    "WITA-8" "\0"
+    "KST-8:30" "\0"
+    "KST-9" "\0"
+    "<+0330>-3:30<+0430>,J80/0,J264/0" "\0"
+    "JST-9" "\0"
+    "<+0630>-6:30" "\0"
+    "WET0WEST,M3.5.0/1,M10.5.0" "\0"
+    "<-01>1" "\0"
+    "ACST-9:30ACDT,M10.1.0,M4.1.0/3" "\0"
+    "AEST-10" "\0"
+    "AEST-10AEDT,M10.1.0,M4.1.0/3" "\0"
+    "ACST-9:30" "\0"
+    "<+0845>-8:45" "\0"
+    "<+1030>-10:30<+11>-11,M10.1.0,M4.1.0" "\0"
+    "AWST-8" "\0"
+    "<+01>-1" "\0"
+    "<+13>-13" "\0"
+    "<+14>-14" "\0"
+    "<+02>-2" "\0"
+    "<-10>10" "\0"
+    "<-11>11" "\0"
+    "<-12>12" "\0"
+    "<-06>6" "\0"
+    "<-07>7" "\0"
+    "<-08>8" "\0"
+    "<-09>9" "\0"
+    "UCT0" "\0"
+    "UTC0" "\0"
+    "EET-2EEST,M3.5.0,M10.5.0/3" "\0"
+    "GMT0IST,M3.5.0/1,M10.5.0" "\0"
+    "GMT0BST,M3.5.0/1,M10.5.0" "\0"
+    "MSK-3" "\0"
+    "<+13>-13<+14>,M9.5.0/3,M4.1.0/4" "\0"
+    "<+1245>-12:45<+1345>,M9.5.0/2:45,M4.1.0/3:45" "\0"
+    "<-06>6<-05>,M8.2.6/22,M5.2.6/22" "\0"
+    "<+12>-12<+13>,M11.1.0,M1.2.1/147" "\0"
+    "ChST-10" "\0"
+    "HST10" "\0"
+    "<-0930>9:30" "\0"
+    "SST11" "\0"
+    ;
+
+static const char tzdb_names [] PROGMEM =
+    "Africa_Abidjan\0"
+    "Africa_Accra\0"
+    "Africa_Addis_Ababa\0"
+    "Africa_Algiers\0"
+    "Africa_Asmara\0"
+    "Africa_Bamako\0"
+    "Africa_Bangui\0"
+    "Africa_Banjul\0"
+    "Africa_Bissau\0"
+    "Africa_Blantyre\0"
+    "Africa_Brazzaville\0"
+    "Africa_Bujumbura\0"
+    "Africa_Cairo\0"
+    "Africa_Casablanca\0"
+    "Africa_Ceuta\0"
+    "Africa_Conakry\0"
+    "Africa_Dakar\0"
+    "Africa_Dar_es_Salaam\0"
+    "Africa_Djibouti\0"
+    "Africa_Douala\0"
+    "Africa_El_Aaiun\0"
+    "Africa_Freetown\0"
+    "Africa_Gaborone\0"
+    "Africa_Harare\0"
+    "Africa_Johannesburg\0"
+    "Africa_Juba\0"
+    "Africa_Kampala\0"
+    "Africa_Khartoum\0"
+    "Africa_Kigali\0"
+    "Africa_Kinshasa\0"
+    "Africa_Lagos\0"
+    "Africa_Libreville\0"
+    "Africa_Lome\0"
+    "Africa_Luanda\0"
+    "Africa_Lubumbashi\0"
+    "Africa_Lusaka\0"
+    "Africa_Malabo\0"
+    "Africa_Maputo\0"
+    "Africa_Maseru\0"
+    "Africa_Mbabane\0"
+    "Africa_Mogadishu\0"
+    "Africa_Monrovia\0"
+    "Africa_Nairobi\0"
+    "Africa_Ndjamena\0"
+    "Africa_Niamey\0"
+    "Africa_Nouakchott\0"
+    "Africa_Ouagadougou\0"
+    "Africa_PortomNovo\0"
+    "Africa_Sao_Tome\0"
+    "Africa_Tripoli\0"
+    "Africa_Tunis\0"
+    "Africa_Windhoek\0"
+    "America_Adak\0"
+    "America_Anchorage\0"
+    "America_Anguilla\0"
+    "America_Antigua\0"
+    "America_Araguaina\0"
+    "America_Argentina_Buenos_Aires\0"
+    "America_Argentina_Catamarca\0"
+    "America_Argentina_Cordoba\0"
+    "America_Argentina_Jujuy\0"
+    "America_Argentina_La_Rioja\0"
+    "America_Argentina_Mendoza\0"
+    "America_Argentina_Rio_Gallegos\0"
+    "America_Argentina_Salta\0"
+    "America_Argentina_San_Juan\0"
+    "America_Argentina_San_Luis\0"
+    "America_Argentina_Tucuman\0"
+    "America_Argentina_Ushuaia\0"
+    "America_Aruba\0"
+    "America_Asuncion\0"
+    "America_Atikokan\0"
+    "America_Bahia\0"
+    "America_Bahia_Banderas\0"
+    "America_Barbados\0"
+    "America_Belem\0"
+    "America_Belize\0"
+    "America_BlancmSablon\0"
+    "America_Boa_Vista\0"
+    "America_Bogota\0"
+    "America_Boise\0"
+    "America_Cambridge_Bay\0"
+    "America_Campo_Grande\0"
+    "America_Cancun\0"
+    "America_Caracas\0"
+    "America_Cayenne\0"
+    "America_Cayman\0"
+    "America_Chicago\0"
+    "America_Chihuahua\0"
+    "America_Costa_Rica\0"
+    "America_Creston\0"
+    "America_Cuiaba\0"
+    "America_Curacao\0"
+    "America_Danmarkshavn\0"
+    "America_Dawson\0"
+    "America_Dawson_Creek\0"
+    "America_Denver\0"
+    "America_Detroit\0"
+    "America_Dominica\0"
+    "America_Edmonton\0"
+    "America_Eirunepe\0"
+    "America_El_Salvador\0"
+    "America_Fort_Nelson\0"
+    "America_Fortaleza\0"
+    "America_Glace_Bay\0"
+    "America_Godthab\0"
+    "America_Goose_Bay\0"
+    "America_Grand_Turk\0"
+    "America_Grenada\0"
+    "America_Guadeloupe\0"
+    "America_Guatemala\0"
+    "America_Guayaquil\0"
+    "America_Guyana\0"
+    "America_Halifax\0"
+    "America_Havana\0"
+    "America_Hermosillo\0"
+    "America_Indiana_Indianapolis\0"
+    "America_Indiana_Knox\0"
+    "America_Indiana_Marengo\0"
+    "America_Indiana_Petersburg\0"
+    "America_Indiana_Tell_City\0"
+    "America_Indiana_Vevay\0"
+    "America_Indiana_Vincennes\0"
+    "America_Indiana_Winamac\0"
+    "America_Inuvik\0"
+    "America_Iqaluit\0"
+    "America_Jamaica\0"
+    "America_Juneau\0"
+    "America_Kentucky_Louisville\0"
+    "America_Kentucky_Monticello\0"
+    "America_Kralendijk\0"
+    "America_La_Paz\0"
+    "America_Lima\0"
+    "America_Los_Angeles\0"
+    "America_Lower_Princes\0"
+    "America_Maceio\0"
+    "America_Managua\0"
+    "America_Manaus\0"
+    "America_Marigot\0"
+    "America_Martinique\0"
+    "America_Matamoros\0"
+    "America_Mazatlan\0"
+    "America_Menominee\0"
+    "America_Merida\0"
+    "America_Metlakatla\0"
+    "America_Mexico_City\0"
+    "America_Miquelon\0"
+    "America_Moncton\0"
+    "America_Monterrey\0"
+    "America_Montevideo\0"
+    "America_Montreal\0"
+    "America_Montserrat\0"
+    "America_Nassau\0"
+    "America_New_York\0"
+    "America_Nipigon\0"
+    "America_Nome\0"
+    "America_Noronha\0"
+    "America_North_Dakota_Beulah\0"
+    "America_North_Dakota_Center\0"
+    "America_North_Dakota_New_Salem\0"
+    "America_Ojinaga\0"
+    "America_Panama\0"
+    "America_Pangnirtung\0"
+    "America_Paramaribo\0"
+    "America_Phoenix\0"
+    "America_Port_of_Spain\0"
+    "America_PortmaumPrince\0"
+    "America_Porto_Velho\0"
+    "America_Puerto_Rico\0"
+    "America_Punta_Arenas\0"
+    "America_Rainy_River\0"
+    "America_Rankin_Inlet\0"
+    "America_Recife\0"
+    "America_Regina\0"
+    "America_Resolute\0"
+    "America_Rio_Branco\0"
+    "America_Santarem\0"
+    "America_Santiago\0"
+    "America_Santo_Domingo\0"
+    "America_Sao_Paulo\0"
+    "America_Scoresbysund\0"
+    "America_Sitka\0"
+    "America_St_Barthelemy\0"
+    "America_St_Johns\0"
+    "America_St_Kitts\0"
+    "America_St_Lucia\0"
+    "America_St_Thomas\0"
+    "America_St_Vincent\0"
+    "America_Swift_Current\0"
+    "America_Tegucigalpa\0"
+    "America_Thule\0"
+    "America_Thunder_Bay\0"
+    "America_Tijuana\0"
+    "America_Toronto\0"
+    "America_Tortola\0"
+    "America_Vancouver\0"
+    "America_Whitehorse\0"
+    "America_Winnipeg\0"
+    "America_Yakutat\0"
+    "America_Yellowknife\0"
+    "Antarctica_Casey\0"
+    "Antarctica_Davis\0"
+    "Antarctica_DumontDUrville\0"
+    "Antarctica_Macquarie\0"
+    "Antarctica_Mawson\0"
+    "Antarctica_McMurdo\0"
+    "Antarctica_Palmer\0"
+    "Antarctica_Rothera\0"
+    "Antarctica_Syowa\0"
+    "Antarctica_Troll\0"
+    "Antarctica_Vostok\0"
+    "Arctic_Longyearbyen\0"
+    "Asia_Aden\0"
+    "Asia_Almaty\0"
+    "Asia_Amman\0"
+    "Asia_Anadyr\0"
+    "Asia_Aqtau\0"
+    "Asia_Aqtobe\0"
+    "Asia_Ashgabat\0"
+    "Asia_Atyrau\0"
+    "Asia_Baghdad\0"
+    "Asia_Bahrain\0"
+    "Asia_Baku\0"
+    "Asia_Bangkok\0"
+    "Asia_Barnaul\0"
+    "Asia_Beirut\0"
+    "Asia_Bishkek\0"
+    "Asia_Brunei\0"
+    "Asia_Chita\0"
+    "Asia_Choibalsan\0"
+    "Asia_Colombo\0"
+    "Asia_Damascus\0"
+    "Asia_Dhaka\0"
+    "Asia_Dili\0"
+    "Asia_Dubai\0"
+    "Asia_Dushanbe\0"
+    "Asia_Famagusta\0"
+    "Asia_Gaza\0"
+    "Asia_Hebron\0"
+    "Asia_Ho_Chi_Minh\0"
+    "Asia_Hong_Kong\0"
+    "Asia_Hovd\0"
+    "Asia_Irkutsk\0"
+    "Asia_Jakarta\0"
+    "Asia_Jayapura\0"
+    "Asia_Jerusalem\0"
+    "Asia_Kabul\0"
+    "Asia_Kamchatka\0"
+    "Asia_Karachi\0"
+    "Asia_Kathmandu\0"
+    "Asia_Khandyga\0"
+    "Asia_Kolkata\0"
+    "Asia_Krasnoyarsk\0"
+    "Asia_Kuala_Lumpur\0"
+    "Asia_Kuching\0"
+    "Asia_Kuwait\0"
+    "Asia_Macau\0"
+    "Asia_Magadan\0"
+    "Asia_Makassar\0"
+    "Asia_Manila\0"
+    "Asia_Muscat\0"
+    "Asia_Nicosia\0"
+    "Asia_Novokuznetsk\0"
+    "Asia_Novosibirsk\0"
+    "Asia_Omsk\0"
+    "Asia_Oral\0"
+    "Asia_Phnom_Penh\0"
+    "Asia_Pontianak\0"
+    "Asia_Pyongyang\0"
+    "Asia_Qatar\0"
+    "Asia_Qyzylorda\0"
+    "Asia_Riyadh\0"
+    "Asia_Sakhalin\0"
+    "Asia_Samarkand\0"
+    "Asia_Seoul\0"
+    "Asia_Shanghai\0"
+    "Asia_Singapore\0"
+    "Asia_Srednekolymsk\0"
+    "Asia_Taipei\0"
+    "Asia_Tashkent\0"
+    "Asia_Tbilisi\0"
+    "Asia_Tehran\0"
+    "Asia_Thimphu\0"
+    "Asia_Tokyo\0"
+    "Asia_Tomsk\0"
+    "Asia_Ulaanbaatar\0"
+    "Asia_Urumqi\0"
+    "Asia_UstmNera\0"
+    "Asia_Vientiane\0"
+    "Asia_Vladivostok\0"
+    "Asia_Yakutsk\0"
+    "Asia_Yangon\0"
+    "Asia_Yekaterinburg\0"
+    "Asia_Yerevan\0"
+    "Atlantic_Azores\0"
+    "Atlantic_Bermuda\0"
+    "Atlantic_Canary\0"
+    "Atlantic_Cape_Verde\0"
+    "Atlantic_Faroe\0"
+    "Atlantic_Madeira\0"
+    "Atlantic_Reykjavik\0"
+    "Atlantic_South_Georgia\0"
+    "Atlantic_St_Helena\0"
+    "Atlantic_Stanley\0"
+    "Australia_Adelaide\0"
+    "Australia_Brisbane\0"
+    "Australia_Broken_Hill\0"
+    "Australia_Currie\0"
+    "Australia_Darwin\0"
+    "Australia_Eucla\0"
+    "Australia_Hobart\0"
+    "Australia_Lindeman\0"
+    "Australia_Lord_Howe\0"
+    "Australia_Melbourne\0"
+    "Australia_Perth\0"
+    "Australia_Sydney\0"
+    "Etc_GMT\0"
+    "Etc_GMT0\0"
+    "Etc_GMTm0\0"
+    "Etc_GMTm1\0"
+    "Etc_GMTm10\0"
+    "Etc_GMTm11\0"
+    "Etc_GMTm12\0"
+    "Etc_GMTm13\0"
+    "Etc_GMTm14\0"
+    "Etc_GMTm2\0"
+    "Etc_GMTm3\0"
+    "Etc_GMTm4\0"
+    "Etc_GMTm5\0"
+    "Etc_GMTm6\0"
+    "Etc_GMTm7\0"
+    "Etc_GMTm8\0"
+    "Etc_GMTm9\0"
+    "Etc_GMTp0\0"
+    "Etc_GMTp1\0"
+    "Etc_GMTp10\0"
+    "Etc_GMTp11\0"
+    "Etc_GMTp12\0"
+    "Etc_GMTp2\0"
+    "Etc_GMTp3\0"
+    "Etc_GMTp4\0"
+    "Etc_GMTp5\0"
+    "Etc_GMTp6\0"
+    "Etc_GMTp7\0"
+    "Etc_GMTp8\0"
+    "Etc_GMTp9\0"
+    "Etc_Greenwich\0"
+    "Etc_UCT\0"
+    "Etc_UTC\0"
+    "Etc_Universal\0"
+    "Etc_Zulu\0"
+    "Europe_Amsterdam\0"
+    "Europe_Andorra\0"
+    "Europe_Astrakhan\0"
+    "Europe_Athens\0"
+    "Europe_Belgrade\0"
+    "Europe_Berlin\0"
+    "Europe_Bratislava\0"
+    "Europe_Brussels\0"
+    "Europe_Bucharest\0"
+    "Europe_Budapest\0"
+    "Europe_Busingen\0"
+    "Europe_Chisinau\0"
+    "Europe_Copenhagen\0"
+    "Europe_Dublin\0"
+    "Europe_Gibraltar\0"
+    "Europe_Guernsey\0"
+    "Europe_Helsinki\0"
+    "Europe_Isle_of_Man\0"
+    "Europe_Istanbul\0"
+    "Europe_Jersey\0"
+    "Europe_Kaliningrad\0"
+    "Europe_Kiev\0"
+    "Europe_Kirov\0"
+    "Europe_Lisbon\0"
+    "Europe_Ljubljana\0"
+    "Europe_London\0"
+    "Europe_Luxembourg\0"
+    "Europe_Madrid\0"
+    "Europe_Malta\0"
+    "Europe_Mariehamn\0"
+    "Europe_Minsk\0"
+    "Europe_Monaco\0"
+    "Europe_Moscow\0"
+    "Europe_Oslo\0"
+    "Europe_Paris\0"
+    "Europe_Podgorica\0"
+    "Europe_Prague\0"
+    "Europe_Riga\0"
+    "Europe_Rome\0"
+    "Europe_Samara\0"
+    "Europe_San_Marino\0"
+    "Europe_Sarajevo\0"
+    "Europe_Saratov\0"
+    "Europe_Simferopol\0"
+    "Europe_Skopje\0"
+    "Europe_Sofia\0"
+    "Europe_Stockholm\0"
+    "Europe_Tallinn\0"
+    "Europe_Tirane\0"
+    "Europe_Ulyanovsk\0"
+    "Europe_Uzhgorod\0"
+    "Europe_Vaduz\0"
+    "Europe_Vatican\0"
+    "Europe_Vienna\0"
+    "Europe_Vilnius\0"
+    "Europe_Volgograd\0"
+    "Europe_Warsaw\0"
+    "Europe_Zagreb\0"
+    "Europe_Zaporozhye\0"
+    "Europe_Zurich\0"
+    "Indian_Antananarivo\0"
+    "Indian_Chagos\0"
+    "Indian_Christmas\0"
+    "Indian_Cocos\0"
+    "Indian_Comoro\0"
+    "Indian_Kerguelen\0"
+    "Indian_Mahe\0"
+    "Indian_Maldives\0"
+    "Indian_Mauritius\0"
+    "Indian_Mayotte\0"
+    "Indian_Reunion\0"
+    "Pacific_Apia\0"
+    "Pacific_Auckland\0"
+    "Pacific_Bougainville\0"
+    "Pacific_Chatham\0"
+    "Pacific_Chuuk\0"
+    "Pacific_Easter\0"
+    "Pacific_Efate\0"
+    "Pacific_Enderbury\0"
+    "Pacific_Fakaofo\0"
+    "Pacific_Fiji\0"
+    "Pacific_Funafuti\0"
+    "Pacific_Galapagos\0"
+    "Pacific_Gambier\0"
+    "Pacific_Guadalcanal\0"
+    "Pacific_Guam\0"
+    "Pacific_Honolulu\0"
+    "Pacific_Kiritimati\0"
+    "Pacific_Kosrae\0"
+    "Pacific_Kwajalein\0"
+    "Pacific_Majuro\0"
+    "Pacific_Marquesas\0"
+    "Pacific_Midway\0"
+    "Pacific_Nauru\0"
+    "Pacific_Niue\0"
+    "Pacific_Norfolk\0"
+    "Pacific_Noumea\0"
+    "Pacific_Pago_Pago\0"
+    "Pacific_Palau\0"
+    "Pacific_Pitcairn\0"
+    "Pacific_Pohnpei\0"
+    "Pacific_Port_Moresby\0"
+    "Pacific_Rarotonga\0"
+    "Pacific_Saipan\0"
+    "Pacific_Tahiti\0"
+    "Pacific_Tarawa\0"
+    "Pacific_Tongatapu\0"
+    "Pacific_Wake\0"
+    "Pacific_Wallis\0"
+    ;
+
+// { name offset, rule offset }
+static const uint16_t tzdb_index [][2] PROGMEM =
+{
+    {     0,    0 },
+    {    15,    0 },
+    {    28,    5 },
+    {    47,   11 },
+    {    62,    5 },
+    {    76,    0 },
+    {    90,   17 },
+    {   104,    0 },
+    {   118,    0 },
+    {   132,   23 },
+    {   148,   17 },
+    {   167,   23 },
+    {   184,   29 },
+    {   197,   35 },
+    {   215,   61 },
+    {   228,    0 },
+    {   243,    0 },
+    {   256,    5 },
+    {   277,    5 },
+    {   293,   17 },
+    {   307,   35 },
+    {   323,    0 },
+    {   339,   23 },
+    {   355,   23 },
+    {   369,   88 },
+    {   389,    5 },
+    {   401,    5 },
+    {   416,   23 },
+    {   432,   23 },
+    {   446,   17 },
+    {   462,   17 },
+    {   475,   17 },
+    {   493,    0 },
+    {   505,   17 },
+    {   519,   23 },
+    {   537,   23 },
+    {   551,   17 },
+    {   565,   23 },
+    {   579,   88 },
+    {   593,   88 },
+    {   608,    5 },
+    {   625,    0 },
+    {   641,    5 },
+    {   656,   17 },
+    {   672,   17 },
+    {   686,    0 },
+    {   704,    0 },
+    {   723,   17 },
+    {   741,   17 },
+    {   757,   29 },
+    {   772,   11 },
+    {   785,   23 },
+    {   801,   95 },
+    {   814,  119 },
+    {   832,  144 },
+    {   849,  144 },
+    {   865,  149 },
+    {   883,  149 },
+    {   914,  149 },
+    {   942,  149 },
+    {   968,  149 },
+    {   992,  149 },
+    {  1019,  149 },
+    {  1045,  149 },
+    {  1076,  149 },
+    {  1100,  149 },
+    {  1127,  149 },
+    {  1154,  149 },
+    {  1180,  149 },
+    {  1206,  144 },
+    {  1220,  156 },
+    {  1237,  187 },
+    {  1254,  149 },
+    {  1268,  192 },
+    {  1291,  144 },
+    {  1308,  149 },
+    {  1322,  215 },
+    {  1337,  144 },
+    {  1358,  220 },
+    {  1376,  227 },
+    {  1391,  234 },
+    {  1405,  234 },
+    {  1427,  257 },
+    {  1448,  187 },
+    {  1463,  220 },
+    {  1479,  149 },
+    {  1495,  187 },
+    {  1510,  288 },
+    {  1526,  311 },
+    {  1544,  215 },
+    {  1563,  334 },
+    {  1579,  257 },
+    {  1594,  144 },
+    {  1610,    0 },
+    {  1631,  339 },
+    {  1646,  334 },
+    {  1667,  234 },
+    {  1682,  362 },
+    {  1698,  144 },
+    {  1715,  234 },
+    {  1732,  227 },
+    {  1749,  215 },
+    {  1769,  334 },
+    {  1789,  149 },
+    {  1807,  385 },
+    {  1825,  408 },
+    {  1841,  385 },
+    {  1859,  362 },
+    {  1878,  144 },
+    {  1894,  144 },
+    {  1913,  215 },
+    {  1931,  227 },
+    {  1949,  220 },
+    {  1964,  385 },
+    {  1980,  441 },
+    {  1995,  334 },
+    {  2014,  362 },
+    {  2043,  288 },
+    {  2064,  362 },
+    {  2088,  362 },
+    {  2115,  288 },
+    {  2141,  362 },
+    {  2163,  362 },
+    {  2189,  362 },
+    {  2213,  234 },
+    {  2228,  362 },
+    {  2244,  187 },
+    {  2260,  119 },
+    {  2275,  362 },
+    {  2303,  362 },
+    {  2331,  144 },
+    {  2350,  220 },
+    {  2365,  227 },
+    {  2378,  339 },
+    {  2398,  144 },
+    {  2420,  149 },
+    {  2435,  215 },
+    {  2451,  220 },
+    {  2466,  144 },
+    {  2482,  144 },
+    {  2501,  288 },
+    {  2519,  311 },
+    {  2536,  288 },
+    {  2554,  192 },
+    {  2569,  119 },
+    {  2588,  192 },
+    {  2608,  468 },
+    {  2625,  385 },
+    {  2641,  192 },
+    {  2659,  149 },
+    {  2678,  362 },
+    {  2695,  144 },
+    {  2714,  362 },
+    {  2729,  362 },
+    {  2746,  362 },
+    {  2762,  119 },
+    {  2775,  495 },
+    {  2791,  288 },
+    {  2819,  288 },
+    {  2847,  288 },
+    {  2878,  234 },
+    {  2894,  187 },
+    {  2909,  362 },
+    {  2929,  149 },
+    {  2948,  334 },
+    {  2964,  144 },
+    {  2986,  362 },
+    {  3009,  220 },
+    {  3029,  144 },
+    {  3049,  149 },
+    {  3070,  288 },
+    {  3090,  288 },
+    {  3111,  149 },
+    {  3126,  215 },
+    {  3141,  288 },
+    {  3158,  227 },
+    {  3177,  149 },
+    {  3194,  502 },
+    {  3211,  144 },
+    {  3233,  534 },
+    {  3251,  565 },
+    {  3272,  119 },
+    {  3286,  144 },
+    {  3308,  596 },
+    {  3325,  144 },
+    {  3342,  144 },
+    {  3359,  144 },
+    {  3377,  144 },
+    {  3396,  215 },
+    {  3418,  215 },
+    {  3438,  385 },
+    {  3452,  362 },
+    {  3472,  339 },
+    {  3488,  362 },
+    {  3504,  144 },
+    {  3520,  339 },
+    {  3538,  339 },
+    {  3557,  288 },
+    {  3574,  119 },
+    {  3590,  234 },
+    {  3610,  622 },
+    {  3627,  630 },
+    {  3644,  638 },
+    {  3670,  647 },
+    {  3691,  656 },
+    {  3709,  664 },
+    {  3728,  149 },
+    {  3746,  149 },
+    {  3765,  692 },
+    {  3782,  700 },
+    {  3799,  733 },
+    {  3817,   61 },
+    {  3837,  692 },
+    {  3847,  733 },
+    {  3859,  741 },
+    {  3870,  771 },
+    {  3882,  656 },
+    {  3893,  656 },
+    {  3905,  656 },
+    {  3919,  656 },
+    {  3931,  692 },
+    {  3944,  692 },
+    {  3957,  780 },
+    {  3967,  630 },
+    {  3980,  630 },
+    {  3993,  788 },
+    {  4005,  733 },
+    {  4018,  622 },
+    {  4030,  817 },
+    {  4041,  622 },
+    {  4057,  825 },
+    {  4070,  838 },
+    {  4084,  733 },
+    {  4095,  817 },
+    {  4105,  780 },
+    {  4116,  656 },
+    {  4130,  867 },
+    {  4145,  896 },
+    {  4155,  896 },
+    {  4167,  630 },
+    {  4184,  925 },
+    {  4199,  630 },
+    {  4209,  622 },
+    {  4222,  931 },
+    {  4235,  937 },
+    {  4249,  943 },
+    {  4264,  970 },
+    {  4275,  771 },
+    {  4290,  983 },
+    {  4303,  989 },
+    {  4318,  817 },
+    {  4332, 1002 },
+    {  4345,  630 },
+    {  4362,  622 },
+    {  4380,  622 },
+    {  4393,  692 },
+    {  4405, 1011 },
+    {  4416,  647 },
+    {  4429, 1017 },
+    {  4443,  622 },
+    {  4455,  780 },
+    {  4467,  867 },
+    {  4480,  630 },
+    {  4498,  630 },
+    {  4515,  733 },
+    {  4525,  656 },
+    {  4535,  630 },
+    {  4551,  931 },
+    {  4566, 1024 },
+    {  4581,  692 },
+    {  4592,  733 },
+    {  4607,  692 },
+    {  4619,  647 },
+    {  4633,  656 },
+    {  4648, 1033 },
+    {  4659, 1011 },
+    {  4673,  622 },
+    {  4688,  647 },
+    {  4707, 1011 },
+    {  4719,  656 },
+    {  4733,  780 },
+    {  4746, 1039 },
+    {  4758,  733 },
+    {  4771, 1072 },
+    {  4782,  630 },
+    {  4793,  622 },
+    {  4810,  733 },
+    {  4822,  638 },
+    {  4836,  630 },
+    {  4851,  638 },
+    {  4868,  817 },
+    {  4881, 1078 },
+    {  4893,  656 },
+    {  4912,  780 },
+    {  4925,  565 },
+    {  4941,  385 },
+    {  4958, 1091 },
+    {  4974, 1117 },
+    {  4994, 1091 },
+    {  5009, 1091 },
+    {  5026,    0 },
+    {  5045,  495 },
+    {  5068,    0 },
+    {  5087,  149 },
+    {  5104, 1124 },
+    {  5123, 1155 },
+    {  5142, 1124 },
+    {  5164, 1163 },
+    {  5181, 1192 },
+    {  5198, 1202 },
+    {  5214, 1163 },
+    {  5231, 1155 },
+    {  5250, 1215 },
+    {  5270, 1163 },
+    {  5290, 1252 },
+    {  5306, 1163 },
+    {  5323,    0 },
+    {  5331,    0 },
+    {  5340,    0 },
+    {  5350, 1259 },
+    {  5360,  638 },
+    {  5371,  647 },
+    {  5382,  771 },
+    {  5393, 1267 },
+    {  5404, 1276 },
+    {  5415, 1285 },
+    {  5425,  692 },
+    {  5435,  780 },
+    {  5445,  656 },
+    {  5455,  733 },
+    {  5465,  630 },
+    {  5475,  622 },
+    {  5485,  817 },
+    {  5495,    0 },
+    {  5505, 1117 },
+    {  5515, 1293 },
+    {  5526, 1301 },
+    {  5537, 1309 },
+    {  5548,  495 },
+    {  5558,  149 },
+    {  5568,  220 },
+    {  5578,  227 },
+    {  5588, 1317 },
+    {  5598, 1324 },
+    {  5608, 1331 },
+    {  5618, 1338 },
+    {  5628,    0 },
+    {  5642, 1345 },
+    {  5650, 1350 },
+    {  5658, 1350 },
+    {  5672, 1350 },
+    {  5681,   61 },
+    {  5698,   61 },
+    {  5713,  780 },
+    {  5730,  867 },
+    {  5744,   61 },
+    {  5760,   61 },
+    {  5774,   61 },
+    {  5792,   61 },
+    {  5808,  867 },
+    {  5825,   61 },
+    {  5841,   61 },
+    {  5857, 1355 },
+    {  5873,   61 },
+    {  5891, 1382 },
+    {  5905,   61 },
+    {  5922, 1407 },
+    {  5938,  867 },
+    {  5954, 1407 },
+    {  5973,  692 },
+    {  5989, 1407 },
+    {  6003,   29 },
+    {  6022,  867 },
+    {  6034,  692 },
+    {  6047, 1091 },
+    {  6061,   61 },
+    {  6078, 1407 },
+    {  6092,   61 },
+    {  6110,   61 },
+    {  6124,   61 },
+    {  6137,  867 },
+    {  6154,  692 },
+    {  6167,   61 },
+    {  6181, 1432 },
+    {  6195,   61 },
+    {  6207,   61 },
+    {  6220,   61 },
+    {  6237,   61 },
+    {  6251,  867 },
+    {  6263,   61 },
+    {  6275,  780 },
+    {  6289,   61 },
+    {  6307,   61 },
+    {  6323,  780 },
+    {  6338, 1432 },
+    {  6356,   61 },
+    {  6370,  867 },
+    {  6383,   61 },
+    {  6400,  867 },
+    {  6415,   61 },
+    {  6429,  780 },
+    {  6446,  867 },
+    {  6462,   61 },
+    {  6475,   61 },
+    {  6490,   61 },
+    {  6504,  867 },
+    {  6519,  692 },
+    {  6536,   61 },
+    {  6550,   61 },
+    {  6564,  867 },
+    {  6582,   61 },
+    {  6596,    5 },
+    {  6616,  733 },
+    {  6630,  630 },
+    {  6647, 1078 },
+    {  6660,    5 },
+    {  6674,  656 },
+    {  6691,  780 },
+    {  6703,  656 },
+    {  6719,  780 },
+    {  6736,    5 },
+    {  6751,  780 },
+    {  6766, 1438 },
+    {  6779,  664 },
+    {  6796,  647 },
+    {  6817, 1470 },
+    {  6833,  638 },
+    {  6847, 1515 },
+    {  6862,  647 },
+    {  6876, 1267 },
+    {  6894, 1267 },
+    {  6910, 1547 },
+    {  6923,  771 },
+    {  6940, 1317 },
+    {  6958, 1338 },
+    {  6974,  647 },
+    {  6994, 1580 },
+    {  7007, 1588 },
+    {  7024, 1276 },
+    {  7043,  647 },
+    {  7058,  771 },
+    {  7076,  771 },
+    {  7091, 1594 },
+    {  7109, 1606 },
+    {  7124,  771 },
+    {  7138, 1301 },
+    {  7151,  647 },
+    {  7167,  647 },
+    {  7182, 1606 },
+    {  7200,  817 },
+    {  7214, 1331 },
+    {  7231,  647 },
+    {  7247,  638 },
+    {  7268, 1293 },
+    {  7286, 1580 },
+    {  7301, 1293 },
+    {  7316,  771 },
+    {  7331, 1267 },
+    {  7349,  771 },
+    {  7362,  771 },
+};
+
+#endif // TZDB_POOL_H
@@ -0,0 +1,136 @@
+
+#include <Arduino.h>
+#include <user_interface.h>
+
+#include "EspGoodies.h"
+#include "wifiresume.h"
+
+// layout in user RTC memory, after wifi resume state
+#define BOOT_PROFILE_RTC_BLOCK  (WIFI_RESUME_RTC_BLOCK + (sizeof(wifi_resume_state) + 3) / 4)
+#define BOOT_PROFILE_MAGIC      0xb0070001
+
+struct boot_profile_header
+{
+    uint32_t magic;
+    uint16_t head;      // current boot record
+    uint16_t count;     // valid records
+};
+
+static boot_profile_header header;
+static boot_record current;
+static bool started = false;
+
+static const char* const phase_names [BOOT_PHASES] =
+{
+    "reset", "setup", "wifi", "dhcp", "ntp", "publish", "user1", "user2",
+};
+
+static uint32_t record_block (int idx)
+{
+    return BOOT_PROFILE_RTC_BLOCK + (sizeof(header) + idx * sizeof(boot_record)) / 4;
+}
+
+// microseconds since cpu reset, from the cycle counter
+// system_get_time() is only used to count the counter wraps
+static uint32_t boot_us ()
+{
+    uint32_t mhz = system_get_cpu_freq();
+    uint32_t ccount = ESP.getCycleCount();
+    uint32_t wrap_us = 0xffffffff / mhz;
+    uint32_t cc_us = ccount / mhz;
+    uint32_t sys_us = system_get_time(); // starts a bit later than cpu reset
+    uint32_t wraps = 0;
+    if (sys_us > cc_us)
+        wraps = (sys_us - cc_us + wrap_us / 2) / wrap_us;
+    return cc_us + wraps * wrap_us;
+}
+
+static void boot_start ()
+{
+    started = true;
+
+    if (   !system_rtc_mem_read(BOOT_PROFILE_RTC_BLOCK, &header, sizeof(header))
+        || header.magic != BOOT_PROFILE_MAGIC
+        || header.head >= BOOT_PROFILE_BOOTS
+        || header.count > BOOT_PROFILE_BOOTS)
+    {
+        // power-on: RTC memory is random
+        header.magic = BOOT_PROFILE_MAGIC;
+        header.head = BOOT_PROFILE_BOOTS - 1;
+        header.count = 0;
+    }
+
+    header.head = (header.head + 1) % BOOT_PROFILE_BOOTS;
+    if (header.count < BOOT_PROFILE_BOOTS)
+        header.count++;
+    system_rtc_mem_write(BOOT_PROFILE_RTC_BLOCK, &header, sizeof(header));
+
+    memset(&current, 0, sizeof(current));
+    current.reason = system_get_rst_info()->reason;
+}
+
+void boot_mark (boot_phase phase)
+{
+    uint32_t now = boot_us();
+
+    if (!started)
+        boot_start();
+    if (phase == BOOT_RESET || phase >= BOOT_PHASES || current.us[phase])
+        // only the first time counts
+        return;
+    current.us[phase] = now?: 1;
+    system_rtc_mem_write(record_block(header.head), &current, sizeof(current));
+}
+
+size_t boot_profile_export (boot_record* records, size_t max)
+{
+    if (!started)
+        boot_start();
+
+    size_t n = 0;
+    for (; n < max && n < header.count; n++)
+    {
+        int idx = (header.head + BOOT_PROFILE_BOOTS - n) % BOOT_PROFILE_BOOTS;
+        if (n == 0)
+            records[0] = current;
+        else
+            system_rtc_mem_read(record_block(idx), &records[n], sizeof(boot_record));
+    }
+    return n;
+}
+
+void boot_profile_print (Print& out)
+{
+    boot_record records[BOOT_PROFILE_BOOTS];
+    uint32_t sum[BOOT_PHASES] = { };
+    uint16_t count[BOOT_PHASES] = { };
+    size_t n = boot_profile_export(records, BOOT_PROFILE_BOOTS);
+
+    out.print(F("boot reason"));
+    for (int p = BOOT_SETUP; p < BOOT_PHASES; p++)
+        out.printf(" %8s", phase_names[p]);
+    out.println(F("  (ms since reset)"));
+
+    for (size_t i = 0; i < n; i++)
+    {
+        out.printf("%4d %6u", -(int)i, (unsigned)records[i].reason);
+        for (int p = BOOT_SETUP; p < BOOT_PHASES; p++)
+            if (records[i].us[p])
+            {
+                out.printf(" %8u", (unsigned)(records[i].us[p] / 1000));
+                sum[p] += records[i].us[p] / 1000;
+                count[p]++;
+            }
+            else
+                out.print(F("        -"));
+        out.println();
+    }
+
+    out.print(F("average    "));
+    for (int p = BOOT_SETUP; p < BOOT_PHASES; p++)
+        if (count[p])
+            out.printf(" %8u", (unsigned)(sum[p] / count[p]));
+        else
+            out.print(F("        -"));
+    out.println();
+}
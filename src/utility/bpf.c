@@ -0,0 +1,192 @@
+/*
+ NetDump library - tcpdump-like packet logger facility
+
+ Copyright (c) 2018 David Gauchard. All rights reserved.
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "bpf.h"
+
+// instruction classes and fields
+#define CLASS(c)    ((c) & 0x07)
+#define SIZE(c)     ((c) & 0x18)
+#define MODE(c)     ((c) & 0xe0)
+#define OP(c)       ((c) & 0xf0)
+#define SRC(c)      ((c) & 0x08)
+#define RVAL(c)     ((c) & 0x18)
+#define MISCOP(c)   ((c) & 0xf8)
+
+enum { LD, LDX, ST, STX, ALU, JMP, RET, MISC };
+enum { W = 0x00, H = 0x08, B = 0x10 };
+enum { IMM = 0x00, ABS = 0x20, IND = 0x40, MEM = 0x60, LEN = 0x80, MSH = 0xa0 };
+enum { ADD = 0x00, SUB = 0x10, MUL = 0x20, DIV = 0x30, OR = 0x40, AND = 0x50,
+       LSH = 0x60, RSH = 0x70, NEG = 0x80, MOD = 0x90, XOR = 0xa0 };
+enum { JA = 0x00, JEQ = 0x10, JGT = 0x20, JGE = 0x30, JSET = 0x40 };
+enum { K = 0x00, X = 0x08, A = 0x10 };
+enum { TAX = 0x00, TXA = 0x80 };
+
+bool bpf_check (const struct bpf_insn* prog, size_t count)
+{
+    if (!count || count > 4096)
+        return false;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const struct bpf_insn* p = &prog[i];
+        switch (CLASS(p->code))
+        {
+        case LD:
+        case LDX:
+            if (MODE(p->code) == MEM && p->k >= BPF_MEMWORDS)
+                return false;
+            break;
+        case ST:
+        case STX:
+            if (p->k >= BPF_MEMWORDS)
+                return false;
+            break;
+        case ALU:
+            if ((OP(p->code) == DIV || OP(p->code) == MOD) && SRC(p->code) == K && !p->k)
+                return false;
+            if (OP(p->code) > XOR)
+                return false;
+            break;
+        case JMP:
+            // forward only
+            if (OP(p->code) == JA)
+            {
+                if (p->k >= count - i - 1)
+                    return false;
+            }
+            else if (p->jt >= count - i - 1 || p->jf >= count - i - 1)
+                return false;
+            break;
+        case RET:
+        case MISC:
+            break;
+        }
+    }
+    return CLASS(prog[count - 1].code) == RET;
+}
+
+static inline uint32_t load (const uint8_t* pkt, uint32_t buflen, uint32_t at, int size, bool* ok)
+{
+    uint32_t n = size == W? 4: size == H? 2: 1;
+    if (at > buflen || n > buflen - at)
+    {
+        *ok = false;
+        return 0;
+    }
+    pkt += at;
+    if (n == 4)
+        return ((uint32_t)pkt[0] << 24) | ((uint32_t)pkt[1] << 16) | ((uint32_t)pkt[2] << 8) | pkt[3];
+    if (n == 2)
+        return ((uint32_t)pkt[0] << 8) | pkt[1];
+    return pkt[0];
+}
+
+uint32_t bpf_run (const struct bpf_insn* pc, const uint8_t* pkt, uint32_t wirelen, uint32_t buflen)
+{
+    uint32_t a = 0, x = 0;
+    uint32_t mem[BPF_MEMWORDS];
+    bool ok = true;
+
+    for (;; pc++)
+    {
+        uint16_t code = pc->code;
+        uint32_t k = pc->k;
+        switch (CLASS(code))
+        {
+        case LD:
+            switch (MODE(code))
+            {
+            case IMM: a = k; break;
+            case ABS: a = load(pkt, buflen, k, SIZE(code), &ok); break;
+            case IND: a = load(pkt, buflen, x + k, SIZE(code), &ok); break;
+            case MEM: a = mem[k]; break;
+            case LEN: a = wirelen; break;
+            default: return 0;
+            }
+            if (!ok)
+                return 0;
+            break;
+
+        case LDX:
+            switch (MODE(code))
+            {
+            case IMM: x = k; break;
+            case MEM: x = mem[k]; break;
+            case LEN: x = wirelen; break;
+            case MSH: x = (load(pkt, buflen, k, B, &ok) & 0x0f) << 2; break;
+            default: return 0;
+            }
+            if (!ok)
+                return 0;
+            break;
+
+        case ST:  mem[k] = a; break;
+        case STX: mem[k] = x; break;
+
+        case ALU:
+        {
+            uint32_t v = SRC(code) == X? x: k;
+            switch (OP(code))
+            {
+            case ADD: a += v; break;
+            case SUB: a -= v; break;
+            case MUL: a *= v; break;
+            case DIV: if (!v) return 0; a /= v; break;
+            case MOD: if (!v) return 0; a %= v; break;
+            case OR:  a |= v; break;
+            case AND: a &= v; break;
+            case XOR: a ^= v; break;
+            case LSH: a = v < 32? a << v: 0; break;
+            case RSH: a = v < 32? a >> v: 0; break;
+            case NEG: a = -a; break;
+            }
+            break;
+        }
+
+        case JMP:
+        {
+            uint32_t v = SRC(code) == X? x: k;
+            bool taken;
+            switch (OP(code))
+            {
+            case JA:   pc += k; continue;
+            case JEQ:  taken = a == v; break;
+            case JGT:  taken = a > v; break;
+            case JGE:  taken = a >= v; break;
+            case JSET: taken = (a & v) != 0; break;
+            default: return 0;
+            }
+            pc += taken? pc->jt: pc->jf;
+            break;
+        }
+
+        case RET:
+            return RVAL(code) == A? a: RVAL(code) == X? x: k;
+
+        case MISC:
+            if (MISCOP(code) == TXA)
+                a = x;
+            else
+                x = a;
+            break;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ NetDump library - tcpdump-like packet logger facility
+
+ Copyright (c) 2018 David Gauchard. All rights reserved.
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __BPF_H
+#define __BPF_H
+
+// classic bpf interpreter, for filters compiled by libpcap (tcpdump -dd, rpcap clients)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+struct bpf_insn
+{
+    uint16_t code;
+    uint8_t  jt;
+    uint8_t  jf;
+    uint32_t k;
+};
+
+#define BPF_MEMWORDS 16
+
+// jumps stay inside, ends with a return, no constant division by 0...
+bool bpf_check (const struct bpf_insn* prog, size_t count);
+
+// bytes to keep (0: rejected), prog must have passed bpf_check()
+uint32_t bpf_run (const struct bpf_insn* prog, const uint8_t* pkt, uint32_t wirelen, uint32_t buflen);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __BPF_H
@@ -0,0 +1,94 @@
+#include <string.h>
+
+#include "chksum.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static inline uint32_t fold64 (uint64_t acc)
+{
+    acc = (acc & 0xffffffff) + (acc >> 32);
+    acc = (acc & 0xffffffff) + (acc >> 32);
+    uint32_t sum = (uint32_t)acc;
+    sum = (sum & 0xffff) + (sum >> 16);
+    return (sum & 0xffff) + (sum >> 16);
+}
+
+// 4-byte aligned p, len multiple of 4
+static uint64_t sum32 (const uint32_t* p, size_t len)
+{
+    uint64_t acc = 0;
+
+#if defined(__SSE2__)
+    __m128i zero = _mm_setzero_si128();
+    __m128i a = zero, b = zero;
+    for (; len >= 16; len -= 16, p += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        a = _mm_add_epi64(a, _mm_unpacklo_epi32(v, zero));
+        b = _mm_add_epi64(b, _mm_unpackhi_epi32(v, zero));
+    }
+    a = _mm_add_epi64(a, b);
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, a);
+    acc = lanes[0] + lanes[1];
+#else
+    for (; len >= 16; len -= 16, p += 4)
+        acc += (uint64_t)p[0] + p[1] + p[2] + p[3];
+#endif
+
+    for (; len; len -= 4)
+        acc += *p++;
+    return acc;
+}
+
+uint32_t chksum_add (const void* data, size_t len, uint32_t sum)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t acc = 0;
+    int odd = (uintptr_t)p & 1;
+
+    if (odd && len)
+    {
+        // sum as if shifted by one byte, swapped back below
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        acc += *p << 8;
+#else
+        acc += *p;
+#endif
+        p++;
+        len--;
+    }
+
+    if (((uintptr_t)p & 2) && len >= 2)
+    {
+        acc += *(const uint16_t*)p;
+        p += 2;
+        len -= 2;
+    }
+
+    acc += sum32((const uint32_t*)p, len & ~3);
+    p += len & ~3;
+    len &= 3;
+
+    if (len >= 2)
+    {
+        acc += *(const uint16_t*)p;
+        p += 2;
+        len -= 2;
+    }
+    if (len)
+    {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        acc += *p;
+#else
+        acc += *p << 8;
+#endif
+    }
+
+    uint32_t s = fold64(acc);
+    if (odd)
+        s = ((s & 0xff) << 8) | (s >> 8);
+    return fold64((uint64_t)s + sum);
+}
@@ -0,0 +1,37 @@
+#ifndef __CHKSUM_H
+#define __CHKSUM_H
+
+// internet checksum (rfc1071)
+// 32 bits read at a time into a 64 bits accumulator, carries folded once at the end
+// (sse2 on hosts that have it), any alignment
+// sums are in memory order like lwIP's: store the result as-is in the packet
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// partial sum, not complemented, can be chained (pseudo headers...)
+uint32_t chksum_add (const void* data, size_t len, uint32_t sum);
+
+static inline uint16_t chksum_fold (uint32_t sum)
+{
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+// checksum to store, or 0 when verifying data that includes its checksum
+static inline uint16_t chksum (const void* data, size_t len)
+{
+    return chksum_fold(chksum_add(data, len, 0));
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __CHKSUM_H
@@ -0,0 +1,45 @@
+#include <Arduino.h>
+#include <NetDump.h>
+#include <lwip/init.h>
+#include <new>
+
+#if LWIP_VERSION_MAJOR != 1
+
+#include <lwip/inet_chksum.h>
+#include "chksum.h"
+
+#define BENCH_RUNS 64
+
+void netDumpChksumBench (Print& out)
+{
+    static const uint16_t sizes [] = { 20, 64, 576, 1460 };
+    char* buf = new (std::nothrow) char[1460 + 4];
+    if (!buf)
+        return;
+    for (int i = 0; i < 1460 + 4; i++)
+        buf[i] = i * 31 + 7;
+
+    out.println(F("bytes align  inet_chksum  chksum  (cycles)"));
+    for (uint16_t size: sizes)
+        for (int align = 0; align < 4; align++)
+        {
+            const char* data = buf + align;
+            uint16_t ref = 0, fast = 0;
+
+            uint32_t start = ESP.getCycleCount();
+            for (int i = 0; i < BENCH_RUNS; i++)
+                ref = inet_chksum(data, size);
+            uint32_t lwip = (ESP.getCycleCount() - start) / BENCH_RUNS;
+
+            start = ESP.getCycleCount();
+            for (int i = 0; i < BENCH_RUNS; i++)
+                fast = chksum(data, size);
+            uint32_t mine = (ESP.getCycleCount() - start) / BENCH_RUNS;
+
+            out.printf("%5u %5d %12u %7u%s\r\n", size, align, (unsigned)lwip, (unsigned)mine, ref == fast? "": "  MISMATCH");
+        }
+
+    delete [] buf;
+}
+
+#endif // !lwip-v1
@@ -1,12 +1,321 @@
 
 #include <time.h>
 #include <stdlib.h>
+#include <limits>
 #include <WString.h>
 
 #include "EspGoodies.h"
+#include "TZdb.h"
+
+#define TZ_MAX_LEN 64 // longest TZ.h rule is 44
+
+// POSIX TZ rule, parsed once by configTZ()
+// offsets are east-positive seconds (local = utc + offset)
+
+struct tz_date
+{
+    char type;      // 'J' (1..365, no Feb 29), 'n' (0..365), 'M' (month.week.day)
+    int16_t day;    // J, n
+    uint8_t m, w, d;
+    int32_t secs;   // local time of the day
+};
+
+static int32_t tz_std, tz_dst;
+static bool tz_has_dst;
+static tz_date tz_start, tz_end;
+
+// transition table for two years, and cached current interval
+static time_t tz_tab_lo = 0, tz_tab_hi = 0;
+static time_t tz_trans[4];
+static int32_t tz_trans_off[4];
+static time_t tz_lo = std::numeric_limits<time_t>::min();
+static time_t tz_hi = std::numeric_limits<time_t>::max();
+static int32_t tz_off = 0;
+
+static bool tz_isdigit (char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static const char* tz_parse_name (const char* p)
+{
+    if (*p == '<')
+    {
+        while (*p && *p != '>')
+            p++;
+        return *p? p + 1: nullptr;
+    }
+    const char* start = p;
+    while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z'))
+        p++;
+    return p - start >= 3? p: nullptr;
+}
+
+static int tz_parse_num (const char*& p)
+{
+    int n = 0;
+    while (tz_isdigit(*p))
+        n = n * 10 + *p++ - '0';
+    return n;
+}
+
+// [+-]hh[:mm[:ss]]
+static const char* tz_parse_time (const char* p, int32_t* secs)
+{
+    int sign = 1;
+    if (*p == '+' || *p == '-')
+        sign = *p++ == '-'? -1: 1;
+    if (!tz_isdigit(*p))
+        return nullptr;
+    int32_t t = tz_parse_num(p) * 3600;
+    if (*p == ':')
+    {
+        p++;
+        t += tz_parse_num(p) * 60;
+        if (*p == ':')
+        {
+            p++;
+            t += tz_parse_num(p);
+        }
+    }
+    *secs = sign * t;
+    return p;
+}
+
+// Jn | n | Mm.w.d, then [/time]
+static const char* tz_parse_date (const char* p, tz_date* date)
+{
+    if (*p == 'M')
+    {
+        p++;
+        date->type = 'M';
+        date->m = tz_parse_num(p);
+        if (*p++ != '.')
+            return nullptr;
+        date->w = tz_parse_num(p);
+        if (*p++ != '.')
+            return nullptr;
+        date->d = tz_parse_num(p);
+        if (date->m < 1 || date->m > 12 || date->w < 1 || date->w > 5 || date->d > 6)
+            return nullptr;
+    }
+    else
+    {
+        date->type = 'n';
+        if (*p == 'J')
+        {
+            p++;
+            date->type = 'J';
+        }
+        if (!tz_isdigit(*p))
+            return nullptr;
+        date->day = tz_parse_num(p);
+    }
+    date->secs = 2 * 3600;
+    if (*p == '/')
+        p = tz_parse_time(p + 1, &date->secs);
+    return p;
+}
+
+static bool tz_parse (const char* p)
+{
+    int32_t secs;
+
+    tz_has_dst = false;
+    if (!(p = tz_parse_name(p)) || !(p = tz_parse_time(p, &secs)))
+        return false;
+    tz_std = tz_dst = -secs;
+    if (!*p)
+        return true;
+
+    if (!(p = tz_parse_name(p)))
+        return false;
+    tz_dst = tz_std + 3600;
+    if (*p && *p != ',')
+    {
+        if (!(p = tz_parse_time(p, &secs)))
+            return false;
+        tz_dst = -secs;
+    }
+    if (*p != ',')
+    {
+        // no rule: the POSIX default is unspecified, use US rules like newlib
+        tz_start = { 'M', 0, 3, 2, 0, 2 * 3600 };
+        tz_end = { 'M', 0, 11, 1, 0, 2 * 3600 };
+    }
+    else if (   !(p = tz_parse_date(p + 1, &tz_start))
+             || *p != ','
+             || !(p = tz_parse_date(p + 1, &tz_end)))
+        return false;
+    tz_has_dst = true;
+    return true;
+}
+
+static bool tz_leap (int y)
+{
+    return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+// days since 1970-01-01 (proleptic gregorian)
+static int32_t tz_days (int y, int m, int d)
+{
+    y -= m <= 2;
+    int32_t era = (y >= 0? y: y - 399) / 400;
+    int32_t yoe = y - era * 400;
+    int32_t doy = (153 * (m + (m > 2? -3: 9)) + 2) / 5 + d - 1;
+    int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static int tz_year (time_t t)
+{
+    int32_t z = (int32_t)((t >= 0? t: t - 86399) / 86400) + 719468;
+    int32_t era = (z >= 0? z: z - 146096) / 146097;
+    int32_t doe = z - era * 146097;
+    int32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int32_t mp = (5 * doy + 2) / 153;
+    return yoe + era * 400 + (mp >= 10);
+}
+
+// utc time of a transition, offset is the one in effect before it
+static time_t tz_transition (int y, const tz_date& date, int32_t offset)
+{
+    int32_t days;
+    if (date.type == 'J')
+        days = tz_days(y, 1, 1) + date.day - 1 + (tz_leap(y) && date.day >= 60);
+    else if (date.type == 'n')
+        days = tz_days(y, 1, 1) + date.day;
+    else
+    {
+        static const uint8_t mdays [] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        int len = mdays[date.m - 1] + (date.m == 2 && tz_leap(y));
+        days = tz_days(y, date.m, 1);
+        int dow = (days % 7 + 11) % 7; // 1970-01-01 was a thursday
+        int mday = (date.d - dow + 7) % 7 + (date.w - 1) * 7;
+        if (mday >= len)
+            mday -= 7;
+        days += mday;
+    }
+    return (time_t)days * 86400 + date.secs - offset;
+}
+
+static void tz_build (int y)
+{
+    int n = 0;
+    for (int i = 0; i < 2; i++)
+    {
+        tz_trans[n] = tz_transition(y + i, tz_start, tz_std);
+        tz_trans_off[n++] = tz_dst;
+        tz_trans[n] = tz_transition(y + i, tz_end, tz_dst);
+        tz_trans_off[n++] = tz_std;
+    }
+    // sort, southern hemisphere ends DST before starting it
+    for (int i = 1; i < 4; i++)
+        for (int j = i; j > 0 && tz_trans[j] < tz_trans[j - 1]; j--)
+        {
+            time_t t = tz_trans[j];
+            tz_trans[j] = tz_trans[j - 1];
+            tz_trans[j - 1] = t;
+            int32_t o = tz_trans_off[j];
+            tz_trans_off[j] = tz_trans_off[j - 1];
+            tz_trans_off[j - 1] = o;
+        }
+    tz_tab_lo = (time_t)tz_days(y, 1, 1) * 86400;
+    tz_tab_hi = (time_t)tz_days(y + 2, 1, 1) * 86400;
+}
+
+static time_t tz_local_slow (time_t utc)
+{
+    if (!tz_has_dst)
+    {
+        tz_lo = std::numeric_limits<time_t>::min();
+        tz_hi = std::numeric_limits<time_t>::max();
+        tz_off = tz_std;
+        return utc + tz_off;
+    }
+
+    if (utc < tz_tab_lo || utc >= tz_tab_hi)
+        tz_build(tz_year(utc));
+
+    int i = 0;
+    while (i < 4 && tz_trans[i] <= utc)
+        i++;
+    tz_lo = i? tz_trans[i - 1]: tz_tab_lo;
+    tz_hi = i < 4? tz_trans[i]: tz_tab_hi;
+    tz_off = i? tz_trans_off[i - 1]: tz_trans_off[0] == tz_dst? tz_std: tz_dst;
+    return utc + tz_off;
+}
+
+time_t TZToLocal (time_t utc)
+{
+    if (utc >= tz_lo && utc < tz_hi)
+        return utc + tz_off;
+    return tz_local_slow(utc);
+}
+
+void TZToLocal (const time_t* utc, time_t* local, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        local[i] = utc[i] >= tz_lo && utc[i] < tz_hi? utc[i] + tz_off: tz_local_slow(utc[i]);
+}
 
 void configTZ (const __FlashStringHelper* TZ)
 {
-    setenv("TZ", String(TZ).c_str(), 1/*overwrite*/);
+    char tz[TZ_MAX_LEN];
+    strncpy_P(tz, (PGM_P)TZ, sizeof(tz) - 1);
+    tz[sizeof(tz) - 1] = 0;
+
+    setenv("TZ", tz, 1/*overwrite*/);
     tzset();
+
+    if (!tz_parse(tz))
+        // unknown syntax, TZToLocal() is UTC
+        tz_std = tz_dst = 0, tz_has_dst = false;
+    tz_tab_lo = tz_tab_hi = 0;
+    tz_lo = tz_hi = 0; // invalidate
+}
+
+// compares "Europe/Paris" or "Etc/GMT+1" to TZ.h names ("Europe_Paris", "Etc_GMTp1")
+static int tzdb_cmp (const char* name, const char* entry)
+{
+    for (;; name++, entry++)
+    {
+        char c = *name;
+        if (c == '/')
+            c = '_';
+        else if (c == '-')
+            c = 'm';
+        else if (c == '+')
+            c = 'p';
+        char e = pgm_read_byte(entry);
+        if (c != e || !c)
+            return (unsigned char)c - (unsigned char)e;
+    }
+}
+
+const __FlashStringHelper* TZByName (const char* name)
+{
+    int lo = 0, hi = TZDB_ZONES - 1;
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+        int cmp = tzdb_cmp(name, tzdb_names + pgm_read_word(&tzdb_index[mid][0]));
+        if (cmp == 0)
+            return FPSTR(tzdb_rules + pgm_read_word(&tzdb_index[mid][1]));
+        if (cmp < 0)
+            hi = mid - 1;
+        else
+            lo = mid + 1;
+    }
+    return nullptr;
+}
+
+bool configTZByName (const char* name)
+{
+    const __FlashStringHelper* TZ = TZByName(name);
+    if (!TZ)
+        return false;
+    configTZ(TZ);
+    return true;
 }
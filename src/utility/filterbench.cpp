@@ -0,0 +1,77 @@
+#include <Arduino.h>
+#include <NetDumpFilter.h>
+
+#define BENCH_RUNS 256
+
+using namespace netdump_filter;
+
+constexpr auto https_or_arp = (Ipv4 && Tcp && DstPort<443>) || Arp;
+
+// the same, written by hand with the same checks
+static bool __attribute__((noinline)) by_hand (const char* d, size_t size)
+{
+    if (size < ETH_HDR_LEN + 20)
+        return false;
+    if (netDump_is_ARP(d))
+        return size >= ETH_HDR_LEN + 28;
+    return netDump_is_IPv4(d)
+        && netDump_is_TCP(d)
+        && !(ntoh16(d + ETH_HDR_LEN + 6) & 0x1fff)
+        && size >= ETH_HDR_LEN + netDump_getIpHdrLen(d) + 4u
+        && netDump_getDstPort(d) == 443;
+}
+
+static bool __attribute__((noinline)) by_filter (const char* d, size_t size)
+{
+    return match(https_or_arp, d, size);
+}
+
+static size_t frame (char* f, uint16_t ethtype, uint8_t proto, uint16_t dport, size_t size)
+{
+    memset(f, 0, size);
+    f[12] = ethtype >> 8;
+    f[13] = ethtype;
+    f[ETH_HDR_LEN] = 0x45;
+    f[ETH_HDR_LEN + 9] = proto;
+    f[ETH_HDR_LEN + 22] = dport >> 8;
+    f[ETH_HDR_LEN + 23] = dport;
+    return size;
+}
+
+void netDumpFilterBench (Print& out)
+{
+    static const char* const names [] = { "tcp/443", "tcp/80", "udp/443", "arp", "ipv6", "short" };
+    char frames [6][64];
+    size_t sizes [6];
+    sizes[0] = frame(frames[0], 0x0800, 6, 443, 54);
+    sizes[1] = frame(frames[1], 0x0800, 6, 80, 54);
+    sizes[2] = frame(frames[2], 0x0800, 17, 443, 42);
+    sizes[3] = frame(frames[3], 0x0806, 0, 0, 42);
+    sizes[4] = frame(frames[4], 0x86dd, 6, 443, 64);
+    sizes[5] = frame(frames[5], 0x0800, 6, 443, 36);
+
+    out.println(F("frame     hand  filter  (cycles)"));
+    for (int f = 0; f < 6; f++)
+    {
+        bool hand = false, filter = false;
+
+        uint32_t start = ESP.getCycleCount();
+        for (int i = 0; i < BENCH_RUNS; i++)
+        {
+            hand = by_hand(frames[f], sizes[f]);
+            asm volatile ("" ::: "memory");
+        }
+        uint32_t cycles_hand = (ESP.getCycleCount() - start) / BENCH_RUNS;
+
+        start = ESP.getCycleCount();
+        for (int i = 0; i < BENCH_RUNS; i++)
+        {
+            filter = by_filter(frames[f], sizes[f]);
+            asm volatile ("" ::: "memory");
+        }
+        uint32_t cycles_filter = (ESP.getCycleCount() - start) / BENCH_RUNS;
+
+        out.printf("%-8s %5u %7u  %s%s\r\n", names[f], (unsigned)cycles_hand, (unsigned)cycles_filter,
+            filter? "match": "-", hand == filter? "": "  MISMATCH");
+    }
+}
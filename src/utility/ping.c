@@ -54,6 +54,8 @@
 #if LWIP_RAW /* don't build if not configured for use in lwipopts.h */
 
 #include "ping.h"
+#include "trace.h"
+#include "chksum.h"
 
 #include "lwip/mem.h"
 #include "lwip/raw.h"
@@ -61,8 +63,9 @@
 #include "lwip/netif.h"
 #include "lwip/sys.h"
 #include "lwip/timeouts.h"
-#include "lwip/inet_chksum.h"
 #include "lwip/prot/ip4.h"
+#include "lwip/etharp.h"
+#include "lwip/ip4.h"
 
 /**
  * PING_DEBUG: Enable debugging for PING.
@@ -81,6 +84,15 @@
 #define PING_DELAY     1000
 #endif
 
+/** clocks - lwIP's sys_now() follows the port's (possibly virtual) time */
+#ifndef PING_NOW_MS
+#define PING_NOW_MS()  sys_now()
+#endif
+#ifndef PING_NOW_US
+#include <user_interface.h>
+#define PING_NOW_US()  system_get_time()
+#endif
+
 /** ping identifier - must fit on a u16_t */
 #ifndef PING_ID
 #define PING_ID        0xAFAF
@@ -91,21 +103,48 @@
 uint16_t ping_seq_num_send;
 uint16_t ping_seq_num_recv;
 uint8_t ping_should_stop;
+uint8_t ping_paused;
+uint32_t ping_rtt_ms;
 
 static ip_addr_t ping_target;
 static struct raw_pcb *ping_pcb;
-//static u32_t ping_time;
+static u32_t ping_time;
 
 /** Prepare a echo ICMP request */
-static void ping_prepare_echo (struct icmp_echo_hdr *iecho)
+static void ping_prepare_echo (struct icmp_echo_hdr *iecho, u16_t len, u16_t id, u16_t seqno)
 {
+  size_t i;
+
   ICMPH_TYPE_SET(iecho, ICMP_ECHO);
   ICMPH_CODE_SET(iecho, 0);
   iecho->chksum = 0;
-  iecho->id     = PING_ID;
-  iecho->seqno  = lwip_htons(++ping_seq_num_send);
+  iecho->id     = id;
+  iecho->seqno  = lwip_htons(seqno);
+
+  /* fill the data */
+  for (i = 0; i < len - sizeof(struct icmp_echo_hdr); i++)
+    ((char*)iecho)[sizeof(struct icmp_echo_hdr) + i] = (char)i;
 
-  iecho->chksum = inet_chksum(iecho, sizeof(struct icmp_echo_hdr));
+  iecho->chksum = chksum(iecho, len);
+}
+
+static err_t ping_send_echo (struct raw_pcb *raw, const ip_addr_t* target, u16_t id, u16_t seqno, u16_t size)
+{
+  struct pbuf *p;
+  err_t err = ERR_MEM;
+  u16_t len = sizeof(struct icmp_echo_hdr) + size;
+
+  p = pbuf_alloc(PBUF_IP, len, PBUF_RAM);
+  if (!p)
+    return err;
+
+  if ((p->len == p->tot_len) && (p->next == NULL))
+  {
+    ping_prepare_echo((struct icmp_echo_hdr*)p->payload, len, id, seqno);
+    err = raw_sendto(raw, p, target);
+  }
+  pbuf_free(p);
+  return err;
 }
 
 /* Ping using the raw ip */
@@ -124,6 +163,13 @@ ping_recv(void* arg, struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* addr)
     if (iecho->id == PING_ID)
     {
       ping_seq_num_recv = lwip_ntohs(iecho->seqno);
+      trace_instant(TRACE_PING_RECV, ping_seq_num_recv);
+      if (ping_seq_num_recv == ping_seq_num_send)
+      {
+        ping_rtt_ms = PING_NOW_MS() - ping_time;
+        if (ping_rtt_hook)
+          ping_rtt_hook(ping_rtt_ms);
+      }
       pbuf_free(p);
       return 1; /* eat the packet */
     }
@@ -135,22 +181,12 @@ ping_recv(void* arg, struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* addr)
 static void
 ping_send(struct raw_pcb *raw)
 {
-  struct pbuf *p;
-  
   if (((u16_t)(ping_seq_num_send - ping_seq_num_recv)) > PING_MAX_LOST)
     PING_FAULT();
 
-  p = pbuf_alloc(PBUF_IP, sizeof(struct icmp_echo_hdr), PBUF_RAM);
-  if (!p)
-    return;
-
-  if ((p->len == p->tot_len) && (p->next == NULL))
-  {
-    ping_prepare_echo((struct icmp_echo_hdr*)p->payload);
-    raw_sendto(raw, p, &ping_target);
-    //ping_time = sys_now();
-  }
-  pbuf_free(p);
+  ping_send_echo(raw, &ping_target, PING_ID, ++ping_seq_num_send, 0);
+  trace_instant(TRACE_PING_SEND, ping_seq_num_send);
+  ping_time = PING_NOW_MS();
 }
 
 static void ping_clock (void* arg)
@@ -164,7 +200,8 @@ static void ping_clock (void* arg)
     return;
   }
     
-  ping_send(pcb);
+  if (!ping_paused)
+    ping_send(pcb);
   sys_timeout(PING_DELAY, ping_clock, pcb);
 }
 
@@ -183,5 +220,307 @@ int ping_init(const ip_addr_t* ping_addr)
   return 0;
 }
 
+/*
+ * subnet sweep:
+ * a window of probes is kept in flight, refilled by batches on each tick.
+ * sequence numbers are (generation << 8) | index, the slot table is scanned
+ * to match replies and to expire lost probes.
+ */
+
+static u8_t ping_sweep_gen;
+
+static void ping_sweep_set (u8_t* bits, u16_t idx)
+{
+  bits[idx >> 3] |= 1 << (idx & 7);
+}
+
+static void ping_sweep_addr (const struct ping_sweep* s, u16_t idx, ip_addr_t* addr)
+{
+  ip_addr_set_ip4_u32(addr, lwip_htonl(s->first + idx));
+}
+
+static u8_t
+ping_sweep_recv(void* arg, struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* addr)
+{
+  struct ping_sweep* s = (struct ping_sweep*)arg;
+  struct icmp_echo_hdr* iecho;
+  u16_t seq;
+  int i;
+  LWIP_UNUSED_ARG(pcb);
+
+  if (p->tot_len < (PBUF_IP_HLEN + sizeof(struct icmp_echo_hdr)))
+    return 0;
+
+  iecho = (struct icmp_echo_hdr*)((long)p->payload + PBUF_IP_HLEN);
+  if (iecho->id != PING_SWEEP_ID || ICMPH_TYPE(iecho) != ICMP_ER)
+    return 0;
+
+  seq = lwip_ntohs(iecho->seqno);
+  for (i = 0; i < PING_SWEEP_WINDOW; i++)
+    if (s->slot[i].seq && s->slot[i].seq == seq)
+    {
+      u16_t idx = seq & 0xff;
+      ip_addr_t probed;
+      ping_sweep_addr(s, idx, &probed);
+      if (!ip_addr_cmp(&probed, addr))
+        /* same id and seq from another host */
+        return 0;
+      s->rtt_ms[idx] = PING_NOW_MS() - s->slot[i].sent_ms;
+      ping_sweep_set(s->alive, idx);
+      s->arp[idx >> 3] &= ~(1 << (idx & 7));
+      s->replies++;
+      s->slot[i].seq = 0;
+      pbuf_free(p);
+      return 1;
+    }
+
+  return 0; /* another sweep, or late or duplicate reply */
+}
+
+static void ping_sweep_clock (void* arg)
+{
+  struct ping_sweep* s = (struct ping_sweep*)arg;
+  u32_t now = PING_NOW_MS();
+  int i, busy = 0, sent = 0, stalled = 0;
+
+  for (i = 0; i < PING_SWEEP_WINDOW; i++)
+  {
+#if LWIP_ARP
+    if (s->slot[i].seq)
+    {
+      /* may be silent on ICMP but answer ARP: checked on every tick, the
+       * entry may be recycled before the timeout (lwIP recycles stable
+       * entries first, pending ones of silent addresses stay for seconds) */
+      u16_t idx = s->slot[i].seq & 0xff;
+      ip_addr_t addr;
+      struct eth_addr* eth_ret;
+      const ip4_addr_t* ip_ret;
+      ping_sweep_addr(s, idx, &addr);
+      if (!ping_sweep_is_arp(s, idx) && etharp_find_addr(NULL, ip_2_ip4(&addr), &eth_ret, &ip_ret) >= 0)
+        ping_sweep_set(s->arp, idx);
+    }
+#endif
+
+    if (s->slot[i].seq)
+    {
+      u32_t timeout = PING_SWEEP_TIMEOUT;
+#if LWIP_ARP
+      /* nobody answered ARP: most of a sweep, release the slot early */
+      if (!ping_sweep_is_arp(s, s->slot[i].seq & 0xff))
+        timeout = PING_SWEEP_ARP_TIMEOUT;
+#endif
+      if (now - s->slot[i].sent_ms >= timeout)
+        s->slot[i].seq = 0;
+    }
+
+    if (!s->slot[i].seq && !stalled && sent < PING_SWEEP_BATCH && s->next < s->count)
+    {
+      ip_addr_t addr;
+      ping_sweep_addr(s, s->next, &addr);
+      if (ping_send_echo(s->pcb, &addr, PING_SWEEP_ID, (s->gen << 8) | s->next, 0) != ERR_OK)
+        /* out of memory or no route yet, retry on next tick, keep expiring */
+        stalled = 1;
+      else
+      {
+        s->slot[i].seq = (s->gen << 8) | s->next;
+        s->slot[i].sent_ms = now;
+        s->next++;
+        sent++;
+      }
+    }
+
+    if (s->slot[i].seq)
+      busy++;
+  }
+
+  if (busy || s->next < s->count)
+  {
+    sys_timeout(PING_SWEEP_TICK, ping_sweep_clock, s);
+    return;
+  }
+
+  ping_sweep_stop(s);
+  if (s->done)
+    s->done(s);
+}
+
+int ping_sweep_start (struct ping_sweep* s, const ip_addr_t* first, uint16_t count, void (*done) (struct ping_sweep*))
+{
+  if (s->running || !count || count > PING_SWEEP_MAX)
+    return 0;
+
+  memset(s, 0, sizeof(*s));
+  s->first = lwip_ntohl(ip_addr_get_ip4_u32(first));
+  s->count = count;
+  s->done = done;
+  if (!++ping_sweep_gen)
+    ping_sweep_gen = 1; /* keep seq != 0 */
+  s->gen = ping_sweep_gen;
+
+  if ((s->pcb = raw_new(IP_PROTO_ICMP)))
+  {
+    raw_recv(s->pcb, ping_sweep_recv, s);
+    if (raw_bind(s->pcb, IP_ADDR_ANY) == ERR_OK)
+    {
+      s->running = 1;
+      ping_sweep_clock(s);
+      return 1;
+    }
+    raw_remove(s->pcb);
+    s->pcb = NULL;
+  }
+  return 0;
+}
+
+void ping_sweep_stop (struct ping_sweep* s)
+{
+  if (!s->running)
+    return;
+  sys_untimeout(ping_sweep_clock, s);
+  raw_remove(s->pcb);
+  s->pcb = NULL;
+  s->running = 0;
+}
+
+/*
+ * packet train:
+ * echoes are sent back-to-back, the bottleneck link spaces them out,
+ * and the spacing is measured on the replies.
+ * sequence numbers are (generation << 8) | position.
+ */
+
+static u8_t ping_train_gen;
+
+static void ping_train_end (void* arg)
+{
+  struct ping_train* t = (struct ping_train*)arg;
+  u32_t first = 0, last = 0, min_gap = 0;
+  u32_t bits = (PBUF_IP_HLEN + sizeof(struct icmp_echo_hdr) + t->size) * 8;
+  int i, prev = -1, first_pos = 0, last_pos = 0;
+
+  for (i = 0; i < t->count; i++)
+  {
+    u32_t rx = t->rx_us[i];
+    if (!rx)
+      continue;
+    if (!t->rtt_min_us || rx - t->tx_us[i] < t->rtt_min_us)
+      t->rtt_min_us = rx - t->tx_us[i];
+    if (!first || (s32_t)(rx - first) < 0)
+    {
+      first = rx;
+      first_pos = i;
+    }
+    if (!last || (s32_t)(rx - last) > 0)
+    {
+      last = rx;
+      last_pos = i;
+    }
+    if (prev >= 0 && (s32_t)(rx - t->rx_us[prev]) > 0)
+    {
+      /* a lost echo in between doubles the gap */
+      u32_t gap = (rx - t->rx_us[prev]) / (i - prev);
+      if (!min_gap || gap < min_gap)
+        min_gap = gap;
+    }
+    prev = i;
+  }
+
+  t->dispersion_us = last - first;
+  /* lost echoes in between still took their slot on the bottleneck */
+  if (t->dispersion_us && last_pos > first_pos)
+    t->bandwidth_bps = (u32_t)((u64_t)bits * (last_pos - first_pos) * 1000000 / t->dispersion_us);
+  if (min_gap)
+    t->pair_bps = (u32_t)((u64_t)bits * 1000000 / min_gap);
+
+  raw_remove(t->pcb);
+  t->pcb = NULL;
+  t->running = 0;
+  if (t->done)
+    t->done(t);
+}
+
+static u8_t
+ping_train_recv(void* arg, struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* addr)
+{
+  struct ping_train* t = (struct ping_train*)arg;
+  struct icmp_echo_hdr* iecho;
+  u32_t now = PING_NOW_US();
+  u16_t seq;
+  LWIP_UNUSED_ARG(pcb);
+
+  if (p->tot_len < (PBUF_IP_HLEN + sizeof(struct icmp_echo_hdr)))
+    return 0;
+
+  iecho = (struct icmp_echo_hdr*)((long)p->payload + PBUF_IP_HLEN);
+  if (iecho->id != PING_TRAIN_ID || ICMPH_TYPE(iecho) != ICMP_ER)
+    return 0;
+
+  seq = lwip_ntohs(iecho->seqno);
+  if ((seq >> 8) != t->gen || (seq & 0xff) >= t->count)
+    return 0;
+
+  if (!ip_addr_cmp(&t->target, addr))
+    /* same id and seq from another host */
+    return 0;
+
+  if (!t->rx_us[seq & 0xff])
+  {
+    t->rx_us[seq & 0xff] = now?: 1;
+    if (++t->replies == t->sent)
+    {
+      /* complete, but don't remove the pcb from its own callback */
+      sys_untimeout(ping_train_end, t);
+      sys_timeout(0, ping_train_end, t);
+    }
+  }
+  pbuf_free(p);
+  return 1;
+}
+
+int ping_train_start (struct ping_train* t, const ip_addr_t* target, uint16_t size, uint8_t count, void (*done) (struct ping_train*))
+{
+  struct netif* netif;
+  u8_t i;
+
+  if (t->running || count < 2 || count > PING_TRAIN_MAX)
+    return 0;
+
+  memset(t, 0, sizeof(*t));
+  ip_addr_copy(t->target, *target);
+  t->size = size;
+  t->count = count;
+  t->done = done;
+  if (!++ping_train_gen)
+    ping_train_gen = 1;
+  t->gen = ping_train_gen;
+
+  netif = ip4_route(ip_2_ip4(target));
+  if (netif && PBUF_IP_HLEN + sizeof(struct icmp_echo_hdr) + size > netif->mtu)
+    t->fragmented = 1;
+
+  if (!(t->pcb = raw_new(IP_PROTO_ICMP)))
+    return 0;
+  raw_recv(t->pcb, ping_train_recv, t);
+  if (raw_bind(t->pcb, IP_ADDR_ANY) != ERR_OK)
+  {
+    raw_remove(t->pcb);
+    t->pcb = NULL;
+    return 0;
+  }
+
+  t->running = 1;
+  for (i = 0; i < count; i++)
+  {
+    t->tx_us[i] = PING_NOW_US();
+    if (ping_send_echo(t->pcb, &t->target, PING_TRAIN_ID, (t->gen << 8) | i, size) == ERR_OK)
+      t->sent++;
+    else
+      t->tx_us[i] = 0;
+  }
+
+  sys_timeout(PING_TRAIN_TIMEOUT, ping_train_end, t);
+  return 1;
+}
+
 #endif /* LWIP_RAW */
 #endif // !lwipv1
@@ -7,8 +7,15 @@
 /////////////////////
 // user configurable
 
+// all can be overridden from the command line (-DPING_DELAY=...)
+// ex: a host build against lwIP's unix port with a virtual sys_now()
+
+#ifndef PING_MAX_FAILED_MN
 #define PING_MAX_FAILED_MN  5    // minutes
+#endif
+#ifndef PING_DELAY
 #define PING_DELAY          5000 // milliseconds
+#endif
 extern void pingFault (void);    // to de defined by user
 
 /////////////////////
@@ -18,19 +25,123 @@ extern void pingFault (void);    // to de defined by user
 // informative variables
 extern uint16_t ping_seq_num_send;
 extern uint16_t ping_seq_num_recv;
+extern uint32_t ping_rtt_ms;        // last round-trip time
 
 // set this to 1 to stop ping (will be stopped when it reads 0)
 extern uint8_t ping_should_stop;
 
+// set this to 1 to pause ping while the radio is off
+// (no probe is sent, no fault is detected)
+extern uint8_t ping_paused;
+
 /////////////////////
 // internal config
 
 #define PING_ID             0x8266
+#ifndef PING_MAX_LOST
 #define PING_MAX_LOST       (((PING_MAX_FAILED_MN) * 60000) / (PING_DELAY))
+#endif
+#ifndef PING_FAULT
 #define PING_FAULT()        do { pingFault(); } while (0)
+#endif
 
 int ping_init (const ip_addr_t* ping_addr);
 
+// optional, called with each ping-alive round-trip time
+extern void ping_rtt_hook (uint32_t ms) __attribute__((weak));
+
+/////////////////////
+// subnet sweep
+
+#define PING_SWEEP_MAX      256  // max addresses per sweep
+#define PING_SWEEP_ARP_KEEP 4    // ARP entries left to established neighbours (gateway...)
+// max probes in flight: each one takes an ARP entry, more would fill the table
+// (silent addresses still keep theirs pending for a few seconds, so the gateway's
+// can be recycled during a sweep, it is then resolved again on its next packet)
+#ifndef PING_SWEEP_WINDOW
+#define PING_SWEEP_WINDOW   ((ARP_TABLE_SIZE) > PING_SWEEP_ARP_KEEP? (ARP_TABLE_SIZE) - PING_SWEEP_ARP_KEEP: 1)
+#endif
+#define PING_SWEEP_BATCH    4    // max probes sent per tick
+#define PING_SWEEP_TICK     10   // milliseconds
+#define PING_SWEEP_TIMEOUT  500  // milliseconds, once the address is ARP-resolved
+// a slot whose address is still not ARP-resolved after this is released:
+// on a LAN an ARP reply takes a few ms, so a /24 takes about 4 seconds
+// (raise it for stations in power save, which answer on the next DTIM beacon)
+#ifndef PING_SWEEP_ARP_TIMEOUT
+#define PING_SWEEP_ARP_TIMEOUT 100 // milliseconds
+#endif
+#define PING_SWEEP_ID       0x8267
+
+struct raw_pcb;
+
+// must have static storage, it is used until done() is called
+struct ping_sweep
+{
+    // results, index is the offset from the first address
+    uint8_t  alive[PING_SWEEP_MAX / 8]; // echo reply received
+    uint8_t  arp[PING_SWEEP_MAX / 8];   // no echo reply but ARP-resolved
+    uint16_t rtt_ms[PING_SWEEP_MAX];    // valid when alive
+    uint16_t count;
+    uint16_t replies;
+    uint8_t  running;
+
+    // internal
+    uint32_t first;                     // host order
+    uint16_t next;
+    uint16_t gen;
+    struct
+    {
+        uint16_t seq;                   // 0: free
+        uint32_t sent_ms;
+    } slot[PING_SWEEP_WINDOW];
+    struct raw_pcb* pcb;
+    void (*done) (struct ping_sweep*);
+};
+
+// probes count consecutive addresses starting from first
+int  ping_sweep_start (struct ping_sweep* s, const ip_addr_t* first, uint16_t count, void (*done) (struct ping_sweep*));
+void ping_sweep_stop (struct ping_sweep* s);
+
+static inline int ping_sweep_is_alive (const struct ping_sweep* s, uint16_t idx) { return (s->alive[idx >> 3] >> (idx & 7)) & 1; }
+static inline int ping_sweep_is_arp   (const struct ping_sweep* s, uint16_t idx) { return (s->arp[idx >> 3] >> (idx & 7)) & 1; }
+
+/////////////////////
+// packet-train bandwidth probe
+
+#define PING_TRAIN_MAX      16    // max echoes per train
+#define PING_TRAIN_TIMEOUT  1000  // milliseconds after the train is sent
+#define PING_TRAIN_ID       0x8268
+
+// must have static storage, it is used until done() is called
+struct ping_train
+{
+    // raw samples, index is the position in the train
+    uint32_t tx_us[PING_TRAIN_MAX];
+    uint32_t rx_us[PING_TRAIN_MAX];     // 0: lost
+
+    // results (IP level, replies are the same size as requests)
+    uint32_t bandwidth_bps;             // from whole train dispersion, 0: unknown
+    uint32_t pair_bps;                  // from the tightest consecutive pair, 0: unknown
+    uint32_t dispersion_us;             // first to last reply
+    uint32_t rtt_min_us;
+    uint16_t size;                      // echo payload size
+    uint8_t  count;
+    uint8_t  sent;
+    uint8_t  replies;
+    uint8_t  fragmented;                // larger than the outgoing netif MTU
+    uint8_t  running;
+
+    // internal
+    uint16_t gen;
+    ip_addr_t target;
+    struct raw_pcb* pcb;
+    void (*done) (struct ping_train*);
+};
+
+// sends count back-to-back echoes with size bytes of payload
+// call again with a growing size to check fragmentation / path MTU behaviour
+int ping_train_start (struct ping_train* t, const ip_addr_t* target, uint16_t size, uint8_t count, void (*done) (struct ping_train*));
+
 inline int start_pingalive (uint32_t ipv4)
 {
     ip_addr_t addr = IPADDR4_INIT(ipv4);
@@ -0,0 +1,129 @@
+
+#include <Arduino.h>
+
+#include "EspGoodies.h"
+#include "wifiresume.h"
+
+// PingAlive follows the radio when it is linked in
+extern "C" uint8_t ping_paused __attribute__((weak));
+
+struct radio_msg
+{
+    uint32_t deadline;
+    radio_send_f send;
+    void* arg;
+};
+
+static radio_msg queue[RADIO_QUEUE];
+static int queued = 0;
+
+static enum { STATE_INIT, STATE_OFF, STATE_WAKING, STATE_LINGER } state = STATE_INIT;
+static uint32_t on_since;
+static uint32_t linger_until;
+static uint32_t wake_estimate = RADIO_WAKE_INITIAL;
+
+struct radio_stats radio_stats;
+
+bool radio_enqueue (uint32_t within_ms, radio_send_f send, void* arg)
+{
+    if (queued == RADIO_QUEUE)
+        return false;
+    queue[queued++] = { millis() + within_ms, send, arg };
+    return true;
+}
+
+static void radio_up (uint32_t now)
+{
+    on_since = now;
+    radio_stats.wakeups++;
+    wifi_on();
+    state = STATE_WAKING;
+}
+
+static void radio_down (uint32_t now)
+{
+    if (&ping_paused)
+        ping_paused = 1;
+    wifi_off();
+    radio_stats.on_ms += now - on_since;
+    state = STATE_OFF;
+}
+
+static void radio_flush (uint32_t now, bool connected)
+{
+    // send() may enqueue again, only process what is there now
+    int n = queued;
+    for (int i = 0; i < n; i++)
+    {
+        if ((int32_t)(now - queue[i].deadline) > 0)
+            radio_stats.late++;
+        if (connected)
+            radio_stats.messages++;
+        else
+            radio_stats.failed++;
+        queue[i].send(queue[i].arg, connected);
+    }
+    memmove(queue, queue + n, (queued - n) * sizeof(queue[0]));
+    queued -= n;
+}
+
+void radio_loop ()
+{
+    uint32_t now = millis();
+
+    switch (state)
+    {
+    case STATE_INIT:
+        // saves the current link for a fast resume
+        on_since = now;
+        radio_down(now);
+        radio_stats.on_ms = 0;
+        break;
+
+    case STATE_OFF:
+        if (queued)
+        {
+            uint32_t earliest = queue[0].deadline;
+            for (int i = 1; i < queued; i++)
+                if ((int32_t)(queue[i].deadline - earliest) < 0)
+                    earliest = queue[i].deadline;
+            // wake up at the latest
+            if ((int32_t)(earliest - now) <= (int32_t)(wake_estimate + RADIO_WAKE_MARGIN))
+                radio_up(now);
+        }
+        break;
+
+    case STATE_WAKING:
+        if (wifi_on_ms)
+        {
+            wake_estimate = (wake_estimate * 3 + wifi_on_ms) / 4;
+            if (&ping_paused)
+                ping_paused = 0;
+            radio_flush(now, true);
+            linger_until = now + RADIO_LINGER;
+            state = STATE_LINGER;
+        }
+        else if (now - on_since >= WIFI_RESUME_GIVEUP)
+        {
+            radio_flush(now, false);
+            radio_down(now);
+        }
+        break;
+
+    case STATE_LINGER:
+        if (queued)
+        {
+            // late comers ride along
+            radio_flush(now, true);
+            linger_until = now + RADIO_LINGER;
+        }
+        else if ((int32_t)(now - linger_until) >= 0)
+            radio_down(now);
+        break;
+    }
+}
+
+bool radio_is_on ()
+{
+    return state == STATE_WAKING || state == STATE_LINGER;
+}
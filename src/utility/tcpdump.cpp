@@ -0,0 +1,338 @@
+/*
+ NetDump library - tcpdump-like packet logger facility
+
+ Copyright (c) 2018 David Gauchard. All rights reserved.
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <string.h>
+
+#include <NetDump.h>
+#include "tcpdump.h"
+#include "trace.h"
+
+static const tcpdump_ops* ops;
+static void* ctx;
+static char* buf;
+static size_t bufsize, snaplen, ptr, start;
+static uint16_t svcport;
+static uint32_t collector_ip;
+static uint32_t seq;
+static bool streaming;
+
+size_t tcpdump_err = 0;
+size_t tcpdump_flow_skipped = 0;
+size_t tcpdump_captured = 0;
+size_t tcpdump_buffer_peak = 0;
+
+// per-flow capture budget
+// flows are identified by (proto, addresses, ports), same for both directions,
+// hashed to find their slot
+
+struct flow_key
+{
+    uint32_t a, b;      // addresses, lowest first
+    uint16_t pa, pb;    // their ports
+    uint8_t proto;
+};
+
+struct flow
+{
+    uint32_t hash;      // 0: free
+    flow_key key;
+    uint32_t last_ms;
+    uint32_t bytes;
+    uint16_t packets;
+};
+
+static flow flows[TCPDUMP_FLOWS];
+static uint16_t budget_packets = 0;
+static uint32_t budget_bytes = 0;
+
+void tcpdump_flow_budget (uint16_t packets, uint32_t bytes)
+{
+    budget_packets = packets;
+    budget_bytes = bytes;
+    memset(flows, 0, sizeof(flows));
+}
+
+static void flow_get_key (const char* data, flow_key* key)
+{
+    uint32_t a, b;
+    memcpy(&a, data + ETH_HDR_LEN + 12, 4);
+    memcpy(&b, data + ETH_HDR_LEN + 16, 4);
+    uint16_t pa = netDump_getSrcPort(data);
+    uint16_t pb = netDump_getDstPort(data);
+    if (a > b || (a == b && pa > pb))
+    {
+        // same key for both directions
+        uint32_t t = a; a = b; b = t;
+        uint16_t p = pa; pa = pb; pb = p;
+    }
+    key->a = a;
+    key->b = b;
+    key->pa = pa;
+    key->pb = pb;
+    key->proto = netDump_getIpType(data);
+}
+
+static bool flow_same_key (const flow_key* x, const flow_key* y)
+{
+    return    x->a == y->a && x->b == y->b
+           && x->pa == y->pa && x->pb == y->pb
+           && x->proto == y->proto;
+}
+
+static uint32_t flow_hash (const flow_key* key)
+{
+    // FNV-1a on words
+    uint32_t hash = 2166136261u;
+    hash = (hash ^ key->a) * 16777619u;
+    hash = (hash ^ key->b) * 16777619u;
+    hash = (hash ^ ((key->pa << 16) | key->pb)) * 16777619u;
+    hash = (hash ^ key->proto) * 16777619u;
+    // the low bits (the slot) only depend on the low bits of each word:
+    // bring down the high ones (ports, last address bytes)
+    hash ^= hash >> 16;
+    return hash?: 1;
+}
+
+// true when the packet is within its flow budget
+static bool flow_allows (const char* data, size_t len)
+{
+    if (   !netDump_is_IPv4(data)
+        || len < ETH_HDR_LEN + 20 + 14
+        || len < ETH_HDR_LEN + netDump_getIpHdrLen(data) + 14u
+        || !(netDump_is_TCP(data) || netDump_is_UDP(data)))
+        // arp, icmp...
+        return true;
+
+    if (netDump_is_TCP(data) && (netDump_getTcpFlags(data) & 0x05))
+        // FIN or RST
+        return true;
+
+    uint32_t now = ops->now_ms(ctx);
+    flow_key key;
+    flow_get_key(data, &key);
+    uint32_t hash = flow_hash(&key);
+    int slot = hash % TCPDUMP_FLOWS;
+    flow* f = nullptr;
+    for (int probe = 0; probe < TCPDUMP_FLOW_PROBES; probe++)
+    {
+        flow* candidate = &flows[(slot + probe) % TCPDUMP_FLOWS];
+        if (candidate->hash == hash && flow_same_key(&candidate->key, &key))
+        {
+            f = candidate;
+            break;
+        }
+        // reuse a free or idle slot, else the least recently seen
+        if (   candidate->hash
+            && now - candidate->last_ms >= TCPDUMP_FLOW_IDLE)
+            candidate->hash = 0;
+        if (!f || (f->hash && (!candidate->hash || (int32_t)(candidate->last_ms - f->last_ms) < 0)))
+            f = candidate;
+    }
+
+    if (   f->hash != hash
+        || !flow_same_key(&f->key, &key)
+        || now - f->last_ms >= TCPDUMP_FLOW_IDLE)
+    {
+        f->hash = hash;
+        f->key = key;
+        f->bytes = 0;
+        f->packets = 0;
+    }
+    f->last_ms = now;
+
+    if (   (budget_packets && f->packets >= budget_packets)
+        || (budget_bytes && f->bytes >= budget_bytes))
+        return false;
+    if (f->packets < 0xffff)
+        f->packets++;
+    f->bytes += len;
+    return true;
+}
+
+void tcpdump_begin (const tcpdump_ops* o, void* c, char* b, size_t size,
+                    size_t snap, uint16_t port, uint32_t collector)
+{
+    ops = o;
+    ctx = c;
+    buf = b;
+    bufsize = size;
+    snaplen = (snap + 3) & ~3;
+    svcport = port;
+    collector_ip = collector;
+    seq = 0;
+    streaming = false;
+    start = ptr = collector_ip? TCPDUMP_DGRAM_HDR: 0;
+    if (collector_ip)
+        ops->capture(ctx, true);
+}
+
+void tcpdump_capture (int netif_idx, const char* data, size_t len, int out, int success)
+{
+    (void)success;
+    
+    if (   !collector_ip
+        && netDump_is_IPv4(data)
+        && netDump_is_TCP(data)
+        && (   ( out && netDump_getSrcPort(data) == svcport)
+            || (!out && netDump_getDstPort(data) == svcport)
+           )
+       )
+    {
+        // skip myself
+        return;
+    }
+
+    if (   collector_ip
+        && out
+        && netDump_is_IPv4(data)
+        && netDump_is_UDP(data)
+        && netDump_getDstPort(data) == svcport
+        && !memcmp(data + ETH_HDR_LEN + 16, &collector_ip, 4))
+    {
+        // skip my own datagrams
+        return;
+    }
+
+    if ((budget_packets || budget_bytes) && !flow_allows(data, len))
+    {
+        tcpdump_flow_skipped++;
+        return;
+    }
+    
+    size_t snap = (len + 3) & ~3;
+    if (snaplen < snap)
+        snap = snaplen;
+    
+    if ((ptr + (4*4) + snap) > bufsize)
+    {
+        // no room, lost capture
+        tcpdump_err++;
+        trace_instant(TRACE_CAPTURE_DROP, len);
+        return;
+    }
+
+    if (!buf || snap <= 0)
+        return;
+
+    trace_instant(TRACE_CAPTURE, len);
+
+    // pcap-savefile(5) packet header
+    uint32_t sec, usec;
+    ops->now(ctx, &sec, &usec);
+    *(uint32_t*)&buf[ptr] = sec;
+    *(uint32_t*)&buf[ptr+4] = usec;
+    *(uint32_t*)&buf[ptr+8] = snap;
+    *(uint32_t*)&buf[ptr+12] = len < snap? snap: len;
+
+    memcpy(buf + ptr + 4*4, data, snap > len? len: snap);
+    if (ops->fix_macs && len >= ETH_HDR_LEN && snap >= ETH_HDR_LEN)
+        // restore real mac addresses in output frames
+        ops->fix_macs(ctx, buf + ptr + 4*4, data, len, netif_idx, out);
+    
+    ptr += 4*4 + snap;
+    tcpdump_captured++;
+    if (ptr > tcpdump_buffer_peak)
+        tcpdump_buffer_peak = ptr;
+}
+
+static void send_datagram ()
+{
+    // datagram header: magic, sequence number, snaplen, record count
+    uint16_t count = 0;
+    for (size_t i = TCPDUMP_DGRAM_HDR; i < ptr; i += 4*4 + *(uint32_t*)&buf[i+8])
+        count++;
+    memcpy(&buf[0], "NDU1", 4);
+    *(uint32_t*)&buf[4] = seq++;
+    *(uint16_t*)&buf[8] = snaplen;
+    *(uint16_t*)&buf[10] = count;
+
+    // never waits: a datagram that cannot be sent is lost and
+    // accounted for by the receiver through sequence numbers
+    trace_begin(TRACE_TCPDUMP_WRITE, ptr);
+    size_t len = ptr;
+    ptr = TCPDUMP_DGRAM_HDR;
+    if (!ops->send(ctx, buf, len))
+        tcpdump_err += count;
+    trace_end(TRACE_TCPDUMP_WRITE, len);
+}
+
+void tcpdump_poll ()
+{
+    if (!ops)
+        return;
+
+    if (collector_ip)
+    {
+        if (ptr > start)
+            send_datagram();
+        return;
+    }
+
+    if (ops->accept(ctx))
+    {
+        // pcap-savefile(5) capture preamble
+        *(uint32_t*)&buf[0] = 0xa1b2c3d4;
+        *(uint32_t*)&buf[4] = 0x00040002;
+        *(uint32_t*)&buf[8] = 0;
+        *(uint32_t*)&buf[12] = 0;
+        *(uint32_t*)&buf[16] = snaplen;
+        *(uint32_t*)&buf[20] = 1;
+        ops->send(ctx, buf, 24);
+
+        ptr = 0;
+        streaming = true;
+        ops->capture(ctx, true);
+    }
+    
+    if (streaming && !ops->connected(ctx))
+    {
+        streaming = false;
+        ops->capture(ctx, false);
+    }
+   
+    if (ptr && streaming)
+    {
+        // the buffer can be larger than what the transport takes at once
+        size_t len = ops->writable(ctx);
+        if (len > ptr)
+            len = ptr;
+        if (len)
+        {
+            trace_begin(TRACE_TCPDUMP_WRITE, len);
+            ops->send(ctx, buf, len);
+            trace_end(TRACE_TCPDUMP_WRITE, len);
+            memmove(buf, buf + len, ptr - len);
+            ptr -= len;
+        }
+    }
+}
+
+void tcpdump_buffer (char* b, size_t size)
+{
+    buf = b;
+    bufsize = size;
+    ptr = start;
+}
+
+size_t tcpdump_buffered ()
+{
+    return ptr - start;
+}
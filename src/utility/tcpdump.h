@@ -0,0 +1,69 @@
+/*
+ NetDump library - tcpdump-like packet logger facility
+
+ Copyright (c) 2018 David Gauchard. All rights reserved.
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __TCPDUMP_H
+#define __TCPDUMP_H
+
+// tcpdump server core: filtering, pcap framing, buffering and drop accounting
+// transport, clocks and the capture hook are behind tcpdump_ops, so this part
+// does not depend on the SDK or lwIP (on a host: posix sockets and a packet
+// generator calling tcpdump_capture(), see tools/tcpdump-host, on the esp:
+// WiFiServer/WiFiClient or WiFiUDP and phy_capture, see NetDumpOut.cpp)
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct tcpdump_ops
+{
+    bool     (*accept)    (void* ctx);                                  // stream: a new client replaces the current one
+    bool     (*connected) (void* ctx);                                  // stream: client still there
+    size_t   (*writable)  (void* ctx);                                  // stream: bytes writable without waiting
+    bool     (*send)      (void* ctx, const char* data, size_t len);    // must not block (datagram: one datagram)
+    void     (*now)       (void* ctx, uint32_t* sec, uint32_t* usec);   // packet timestamps
+    uint32_t (*now_ms)    (void* ctx);
+    void     (*capture)   (void* ctx, bool on);                         // enable/disable the capture hook
+    // optional, rewrites the 12 mac bytes of a frame copied in frame
+    void     (*fix_macs)  (void* ctx, char* frame, const char* data, size_t len, int netif_idx, int out);
+};
+
+#define TCPDUMP_DGRAM_HDR 12    // "NDU1", seq (u32), snaplen (u16), count (u16)
+
+// bufsize: a multiple of 4, one datagram at most in datagram mode
+// datagram mode when collector_ip (network order) is not 0
+// svcport: the server's own traffic (or datagrams to the collector) is not captured
+void tcpdump_begin (const tcpdump_ops* ops, void* ctx, char* buf, size_t bufsize,
+                    size_t snap, uint16_t svcport, uint32_t collector_ip);
+
+// phy_capture compatible
+void tcpdump_capture (int netif_idx, const char* data, size_t len, int out, int success);
+
+// flush what is buffered, as much as the transport accepts without waiting
+void tcpdump_poll ();
+
+// replace the buffer (can be nullptr), anything still buffered is lost
+void   tcpdump_buffer   (char* buf, size_t bufsize);
+size_t tcpdump_buffered ();
+
+// besides tcpdump_err and tcpdump_flow_skipped (NetDump.h)
+extern size_t tcpdump_captured;
+extern size_t tcpdump_buffer_peak;  // highest buffer occupancy, bytes
+
+#endif // __TCPDUMP_H
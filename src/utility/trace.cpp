@@ -0,0 +1,43 @@
+
+#include <Arduino.h>
+
+#include "EspGoodies.h"
+
+struct trace_event* trace_ring = nullptr;
+uint32_t trace_mask = 0;
+uint32_t trace_head = 0;
+
+void trace_start (struct trace_event* buffer, uint32_t count)
+{
+    trace_ring = nullptr;
+    trace_head = 0;
+    trace_mask = count - 1;
+    if (count && !(count & trace_mask))
+        trace_ring = buffer;
+}
+
+void trace_stop (void)
+{
+    trace_ring = nullptr;
+}
+
+// header: "TRC1", cpu MHz, event count, then events, oldest first (little endian)
+void trace_dump (Print& out)
+{
+    struct trace_event* ring = trace_ring;
+    uint32_t head = trace_head;
+    uint32_t count = head < trace_mask + 1? head: trace_mask + 1;
+    uint32_t mhz = ESP.getCpuFreqMHz();
+
+    if (!ring)
+        count = 0;
+    trace_ring = nullptr; // freeze
+
+    out.write((const uint8_t*)"TRC1", 4);
+    out.write((const uint8_t*)&mhz, 4);
+    out.write((const uint8_t*)&count, 4);
+    for (uint32_t i = head - count; i != head; i++)
+        out.write((const uint8_t*)&ring[i & trace_mask], sizeof(struct trace_event));
+
+    trace_ring = ring;
+}
@@ -0,0 +1,75 @@
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+// binary trace-event ring
+// disabled (no cost but a test) until trace_start() is given a buffer
+// convert a trace_dump() output with tools/trace2json,
+// then open it in chrome://tracing or ui.perfetto.dev
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define TRACE_BEGIN     0
+#define TRACE_END       1
+#define TRACE_INSTANT   2
+
+// ids, keep in sync with tools/trace2json
+#define TRACE_CAPTURE       1   // instant, arg: packet length
+#define TRACE_CAPTURE_DROP  2   // instant, arg: packet length
+#define TRACE_TCPDUMP_WRITE 3   // begin/end, arg: bytes
+#define TRACE_PING_SEND     4   // instant, arg: seq
+#define TRACE_PING_RECV     5   // instant, arg: seq
+#define TRACE_WIFI_ON       6   // begin (wifi_on) / end (connected, arg: ms)
+#define TRACE_WIFI_OFF      7   // instant
+#define TRACE_USER          32  // first user id (up to 255)
+
+struct trace_event
+{
+    uint32_t cycles;
+    uint8_t  type;
+    uint8_t  id;
+    uint16_t arg;
+};
+
+extern struct trace_event* trace_ring;
+extern uint32_t trace_mask;
+extern uint32_t trace_head;
+
+// count must be a power of 2, the oldest events are overwritten
+void trace_start (struct trace_event* buffer, uint32_t count);
+void trace_stop (void);
+
+#ifndef TRACE_CYCLES
+#ifdef __XTENSA__
+#define TRACE_CYCLES() ({ uint32_t ccount; __asm__ __volatile__("rsr %0,ccount":"=a"(ccount)); ccount; })
+#else
+#define TRACE_CYCLES() 0
+#endif
+#endif
+
+static inline void trace_record (uint8_t type, uint8_t id, uint16_t arg)
+{
+    if (trace_ring)
+    {
+        struct trace_event* e = &trace_ring[trace_head++ & trace_mask];
+        e->cycles = TRACE_CYCLES();
+        e->type = type;
+        e->id = id;
+        e->arg = arg;
+    }
+}
+
+static inline void trace_begin   (uint8_t id, uint16_t arg) { trace_record(TRACE_BEGIN, id, arg); }
+static inline void trace_end     (uint8_t id, uint16_t arg) { trace_record(TRACE_END, id, arg); }
+static inline void trace_instant (uint8_t id, uint16_t arg) { trace_record(TRACE_INSTANT, id, arg); }
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __TRACE_H
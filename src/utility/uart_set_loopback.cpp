@@ -1,7 +1,9 @@
 
+#include <Arduino.h>
 #include <esp8266_peri.h>
 
 #include "EspGoodies.h"
+#include "uartbench.h"
 
 void uart_set_loopback (int uart_nr, bool enable)
 {
@@ -10,3 +12,82 @@ void uart_set_loopback (int uart_nr, bool enable)
 	else
 		USC0(uart_nr) &= ~(1 << UCLBE);
 }
+
+static bool serial_set_baud (void* ctx, uint32_t baud)
+{
+	((HardwareSerial*)ctx)->updateBaudRate(baud);
+	return true;
+}
+
+static size_t serial_write (void* ctx, const uint8_t* data, size_t len)
+{
+	HardwareSerial* serial = (HardwareSerial*)ctx;
+	size_t room = serial->availableForWrite();
+	return serial->write(data, len < room? len: room);
+}
+
+static size_t serial_read (void* ctx, uint8_t* data, size_t len)
+{
+	HardwareSerial* serial = (HardwareSerial*)ctx;
+	size_t n = 0;
+	while (n < len && serial->available())
+		data[n++] = serial->read();
+	return n;
+}
+
+static uint32_t serial_now_us (void*)
+{
+	return micros();
+}
+
+static void serial_yield (void*)
+{
+	yield();
+}
+
+static const uart_bench_ops serial_ops =
+{
+	serial_set_baud,
+	serial_write,
+	serial_read,
+	serial_now_us,
+	serial_yield,
+};
+
+int uart_loopback_bench (HardwareSerial& serial, int uart_nr, uart_bench_result* results, size_t count)
+{
+	static const uint32_t bauds [] = { UART_BENCH_BAUDS };
+	uint32_t restore = serial.baudRate();
+	int best = -1;
+
+	serial.flush();
+	uart_set_loopback(uart_nr, true);
+	for (size_t i = 0; i < count; i++)
+		if (i >= sizeof(bauds) / sizeof(bauds[0]) || !uart_bench_run(&serial_ops, &serial, bauds[i], &results[i]))
+			results[i].baud = 0;
+		else if (uart_bench_reliable(&results[i]))
+			best = i;
+	uart_set_loopback(uart_nr, false);
+	serial.updateBaudRate(restore);
+
+	return best;
+}
+
+void uart_bench_print (Print& out, const uart_bench_result* results, size_t count, int best)
+{
+	out.println(F("    baud    bytes/s     sent     recv   errors  lat-min  lat-avg  lat-max lat-lost"));
+	for (size_t i = 0; i < count; i++)
+	{
+		const uart_bench_result* r = &results[i];
+		if (!r->baud)
+			continue;
+		out.printf("%8u %10u %8u %8u %8u %8u %8u %8u %8u%s\r\n",
+			(unsigned)r->baud, (unsigned)r->bytes_per_s,
+			(unsigned)r->sent, (unsigned)r->received, (unsigned)r->errors,
+			(unsigned)r->lat_min_us, (unsigned)r->lat_avg_us, (unsigned)r->lat_max_us,
+			(unsigned)r->lat_lost,
+			(int)i == best? " <- fastest reliable": "");
+	}
+	if (best < 0)
+		out.println(F("no reliable configuration"));
+}
@@ -0,0 +1,126 @@
+
+#include <string.h>
+
+#include "uartbench.h"
+
+// discard everything until the line is quiet
+static void uart_bench_drain (const uart_bench_ops* ops, void* ctx, uint32_t quiet_us)
+{
+    uint8_t buf[32];
+    uint32_t last = ops->now_us(ctx);
+    while (ops->now_us(ctx) - last < quiet_us)
+    {
+        if (ops->read(ctx, buf, sizeof(buf)))
+            last = ops->now_us(ctx);
+        ops->yield(ctx);
+    }
+}
+
+static void uart_bench_latency (const uart_bench_ops* ops, void* ctx, uart_bench_result* r)
+{
+    uint64_t sum = 0;
+    int count = 0;
+
+    for (int i = 0; i < UART_BENCH_PINGS; i++)
+    {
+        uint8_t out = i * 37 + 1, in;
+        uint32_t start = ops->now_us(ctx), now = start;
+        bool sent = false, back = false;
+
+        while (now - start < UART_BENCH_TIMEOUT_US)
+        {
+            if (!sent)
+                sent = ops->write(ctx, &out, 1) == 1;
+            else if (ops->read(ctx, &in, 1) == 1)
+            {
+                back = true;
+                break;
+            }
+            // up to UART_BENCH_TIMEOUT_US per ping, let the system run
+            ops->yield(ctx);
+            now = ops->now_us(ctx);
+        }
+
+        if (!back)
+        {
+            r->lat_lost++;
+            continue;
+        }
+        now = ops->now_us(ctx) - start;
+        if (in != out)
+            r->errors++;
+
+        if (!count || now < r->lat_min_us)
+            r->lat_min_us = now;
+        if (now > r->lat_max_us)
+            r->lat_max_us = now;
+        sum += now;
+        count++;
+
+        int bucket = 0;
+        while (bucket < UART_BENCH_HIST - 1 && (now >> (bucket + 1)))
+            bucket++;
+        r->lat_hist[bucket]++;
+    }
+
+    if (count)
+        r->lat_avg_us = sum / count;
+}
+
+static void uart_bench_throughput (const uart_bench_ops* ops, void* ctx, uart_bench_result* r)
+{
+    uint8_t buf[64];
+    uint8_t expect = 0;
+    uint32_t start = ops->now_us(ctx), last = start, now;
+
+    // byte n is (uint8_t)n, receiver resynchronizes on each break
+    while ((now = ops->now_us(ctx)) - start < UART_BENCH_DURATION_US || now - last < UART_BENCH_TIMEOUT_US)
+    {
+        if (now - start < UART_BENCH_DURATION_US)
+        {
+            for (size_t i = 0; i < sizeof(buf); i++)
+                buf[i] = r->sent + i;
+            r->sent += ops->write(ctx, buf, sizeof(buf));
+        }
+
+        size_t len = ops->read(ctx, buf, sizeof(buf));
+        if (len)
+            last = ops->now_us(ctx);
+        for (size_t i = 0; i < len; i++)
+        {
+            if (buf[i] != expect)
+                r->errors++;
+            expect = buf[i] + 1;
+        }
+        r->received += len;
+
+        ops->yield(ctx);
+    }
+
+    if (last != start)
+        r->bytes_per_s = (uint64_t)r->received * 1000000 / (last - start);
+}
+
+bool uart_bench_run (const uart_bench_ops* ops, void* ctx, uint32_t baud, uart_bench_result* r)
+{
+    memset(r, 0, sizeof(*r));
+    if (!ops->set_baud(ctx, baud))
+        return false;
+    r->baud = baud;
+
+    uart_bench_drain(ops, ctx, UART_BENCH_TIMEOUT_US);
+    uart_bench_latency(ops, ctx, r);
+    uart_bench_drain(ops, ctx, UART_BENCH_TIMEOUT_US);
+    uart_bench_throughput(ops, ctx, r);
+    return true;
+}
+
+bool uart_bench_reliable (const uart_bench_result* r)
+{
+    // 8N1: 10 bits per byte
+    return    r->baud
+           && !r->errors
+           && !r->lat_lost
+           && r->received == r->sent
+           && r->bytes_per_s >= r->baud / 10 * 9 / 10;
+}
@@ -0,0 +1,44 @@
+
+#ifndef __UARTBENCH_H
+#define __UARTBENCH_H
+
+// serial loopback benchmark core
+// the serial port is behind uart_bench_ops, so this part does not depend on the SDK
+// (on a host: a pty pair, see tools/uart-bench, on the esp: HardwareSerial with uart_set_loopback())
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define UART_BENCH_BAUDS        115200, 230400, 460800, 921600, 1500000, 2000000, 3000000, 4000000
+#define UART_BENCH_DURATION_US  200000  // throughput test length
+#define UART_BENCH_TIMEOUT_US   20000   // a byte not back after this is lost
+#define UART_BENCH_PINGS        64      // latency samples
+#define UART_BENCH_HIST         16      // log2(us) latency buckets
+
+struct uart_bench_ops
+{
+    bool     (*set_baud) (void* ctx, uint32_t baud);
+    size_t   (*write)    (void* ctx, const uint8_t* data, size_t len); // must not block
+    size_t   (*read)     (void* ctx, uint8_t* data, size_t len);       // must not block
+    uint32_t (*now_us)   (void* ctx);
+    void     (*yield)    (void* ctx);
+};
+
+struct uart_bench_result
+{
+    uint32_t baud;                      // 0: not run
+    uint32_t bytes_per_s;
+    uint32_t sent;
+    uint32_t received;
+    uint32_t errors;                    // sequence breaks: 1 per lost byte, 2 per corrupted byte
+    uint32_t lat_min_us;                // single byte round-trip
+    uint32_t lat_avg_us;
+    uint32_t lat_max_us;
+    uint16_t lat_lost;
+    uint16_t lat_hist[UART_BENCH_HIST]; // [i]: 2^i <= us < 2^(i+1), [0] includes 0
+};
+
+bool uart_bench_run      (const uart_bench_ops* ops, void* ctx, uint32_t baud, uart_bench_result* r);
+bool uart_bench_reliable (const uart_bench_result* r); // no error, no loss, >= 90% of line rate
+
+#endif // __UARTBENCH_H
@@ -1,12 +1,143 @@
 
+#include <Arduino.h>
 #include <user_interface.h>
+#include <lwip/dns.h>
+#include <lwip/dhcp.h>
+#include <lwip/netif.h>
 
 #include "EspGoodies.h"
+#include "wifiresume.h"
 
 // https://github.com/esp8266/Arduino/issues/3072#issuecomment-348692479
 
+uint32_t wifi_on_ms = 0;
+bool wifi_on_resumed = false;
+
+static bool sdk_rtc_read (void* data, size_t len)
+{
+    return system_rtc_mem_read(WIFI_RESUME_RTC_BLOCK, data, len);
+}
+
+static bool sdk_rtc_write (const void* data, size_t len)
+{
+    return system_rtc_mem_write(WIFI_RESUME_RTC_BLOCK, data, len);
+}
+
+static bool sdk_get_link (wifi_resume_state* state)
+{
+    struct station_config conf;
+    struct ip_info info;
+
+    if (   wifi_station_get_connect_status() != STATION_GOT_IP
+        || !wifi_station_get_config(&conf)
+        || !wifi_get_ip_info(STATION_IF, &info))
+        return false;
+
+    state->channel = wifi_get_channel();
+    memcpy(state->bssid, conf.bssid, sizeof(state->bssid));
+    state->ip = ip4_addr_get_u32(&info.ip);
+    state->gw = ip4_addr_get_u32(&info.gw);
+    state->mask = ip4_addr_get_u32(&info.netmask);
+    state->dns = ip4_addr_get_u32(ip_2_ip4(dns_getserver(0)));
+
+    // lease time left, counted by lwIP in DHCP_COARSE_TIMER_SECS ticks
+    state->lease_s = 0xffffffff;
+    for (struct netif* netif = netif_list; netif; netif = netif->next)
+        if (netif->num == STATION_IF)
+        {
+            struct dhcp* dhcp = netif_dhcp_data(netif);
+            if (dhcp && dhcp->t0_timeout)
+                state->lease_s = (dhcp->t0_timeout > dhcp->lease_used? dhcp->t0_timeout - dhcp->lease_used: 0) * DHCP_COARSE_TIMER_SECS;
+        }
+    return true;
+}
+
+static void sdk_connect_fast (const wifi_resume_state* state)
+{
+    struct station_config conf;
+    struct ip_info info;
+    ip_addr_t dns;
+
+    // reuse the lease, the DHCP client stays stopped (no renewal): the lease
+    // end saved with this state is kept by wifi_resume_save(), when it is
+    // near the full connection gets a new one
+    wifi_station_dhcpc_stop();
+    ip4_addr_set_u32(&info.ip, state->ip);
+    ip4_addr_set_u32(&info.gw, state->gw);
+    ip4_addr_set_u32(&info.netmask, state->mask);
+    wifi_set_ip_info(STATION_IF, &info);
+    ip_addr_set_ip4_u32(&dns, state->dns);
+    dns_setserver(0, &dns);
+
+    // no scan
+    wifi_station_get_config(&conf);
+    conf.bssid_set = 1;
+    memcpy(conf.bssid, state->bssid, sizeof(conf.bssid));
+    wifi_station_set_config_current(&conf);
+    wifi_set_channel(state->channel);
+    wifi_station_connect();
+}
+
+static void sdk_connect_full ()
+{
+    struct station_config conf;
+
+    wifi_station_disconnect();
+    wifi_station_get_config(&conf);
+    conf.bssid_set = 0;
+    wifi_station_set_config_current(&conf);
+    wifi_station_dhcpc_start();
+    wifi_station_connect();
+}
+
+static bool sdk_connected ()
+{
+    return wifi_station_get_connect_status() == STATION_GOT_IP;
+}
+
+static uint32_t sdk_now_ms ()
+{
+    return millis();
+}
+
+// the RTC counter keeps running in deep sleep, and is reset with RTC memory
+// on power-up (it wraps after about 6 hours: longer sleeps look shorter)
+static uint32_t sdk_clock_s ()
+{
+    return ((uint64_t)system_get_rtc_time() * system_rtc_clock_cali_proc() >> 12) / 1000000;
+}
+
+static const wifi_resume_ops sdk_ops =
+{
+    sdk_rtc_read,
+    sdk_rtc_write,
+    sdk_get_link,
+    sdk_connect_fast,
+    sdk_connect_full,
+    sdk_connected,
+    sdk_now_ms,
+    sdk_clock_s,
+};
+
+static wifi_resume resume = { &sdk_ops, WIFI_RESUME_IDLE, 0, 0, false, 0, 0 };
+static os_timer_t resume_timer;
+
+static void resume_poll (void*)
+{
+    if (wifi_resume_poll(&resume))
+        return;
+    os_timer_disarm(&resume_timer);
+    wifi_on_ms = resume.connected_ms;
+    wifi_on_resumed = resume.resumed;
+    trace_end(TRACE_WIFI_ON, wifi_on_ms);
+}
+
 void wifi_off (void)
 {
+    trace_instant(TRACE_WIFI_OFF, 0);
+    os_timer_disarm(&resume_timer);
+    wifi_resume_save(&resume);
+
     wifi_station_disconnect();
     wifi_set_opmode(NULL_MODE);
     wifi_set_sleep_type(MODEM_SLEEP_T);
@@ -16,8 +147,16 @@ void wifi_off (void)
 
 void wifi_on (void)
 {
+    trace_begin(TRACE_WIFI_ON, 0);
+    wifi_on_ms = 0;
+    wifi_on_resumed = false;
+
     wifi_fpm_do_wakeup();
     wifi_fpm_close();
     wifi_set_opmode(STATION_MODE);
-    wifi_station_connect();
+
+    wifi_resume_start(&resume);
+    os_timer_disarm(&resume_timer);
+    os_timer_setfn(&resume_timer, resume_poll, nullptr);
+    os_timer_arm(&resume_timer, WIFI_RESUME_POLL, true);
 }
@@ -0,0 +1,109 @@
+
+#include "wifiresume.h"
+
+static uint32_t wifi_resume_crc (const wifi_resume_state* state)
+{
+    const uint8_t* data = (const uint8_t*)state + sizeof(state->crc);
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < sizeof(*state) - sizeof(state->crc); i++)
+    {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++)
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+// false when the lease may have expired since it was saved (or the clock was reset)
+static bool wifi_resume_lease_valid (wifi_resume* r, const wifi_resume_state* state)
+{
+    if (state->lease_s == 0xffffffff)
+        return true;
+    uint32_t now = r->ops->clock_s();
+    return    now >= state->saved_s
+           && state->lease_s > WIFI_RESUME_LEASE_MARGIN
+           && now - state->saved_s < state->lease_s - WIFI_RESUME_LEASE_MARGIN;
+}
+
+static void wifi_resume_invalidate (wifi_resume* r)
+{
+    wifi_resume_state state = { };
+    r->ops->rtc_write(&state, sizeof(state));
+}
+
+void wifi_resume_save (wifi_resume* r)
+{
+    wifi_resume_state state = { };
+    r->phase = WIFI_RESUME_IDLE;
+    if (!r->ops->get_link(&state))
+        // not connected, keep the previous state
+        return;
+    if (r->resumed)
+    {
+        // DHCP was not run since the lease was saved (and its counters are
+        // frozen): the lease still ends where it did
+        state.lease_s = r->lease_s;
+        state.saved_s = r->lease_saved_s;
+    }
+    else
+        state.saved_s = r->ops->clock_s();
+    state.crc = wifi_resume_crc(&state);
+    r->ops->rtc_write(&state, sizeof(state));
+}
+
+void wifi_resume_start (wifi_resume* r)
+{
+    wifi_resume_state state;
+
+    r->start_ms = r->ops->now_ms();
+    r->connected_ms = 0;
+    r->resumed = false;
+
+    if (   r->ops->rtc_read(&state, sizeof(state))
+        && state.crc == wifi_resume_crc(&state)
+        && state.channel
+        && state.ip
+        && wifi_resume_lease_valid(r, &state))
+    {
+        r->phase = WIFI_RESUME_FAST;
+        r->lease_s = state.lease_s;
+        r->lease_saved_s = state.saved_s;
+        r->ops->connect_fast(&state);
+    }
+    else
+    {
+        r->phase = WIFI_RESUME_FULL;
+        r->ops->connect_full();
+    }
+}
+
+bool wifi_resume_poll (wifi_resume* r)
+{
+    if (r->phase == WIFI_RESUME_IDLE)
+        return false;
+
+    uint32_t elapsed = r->ops->now_ms() - r->start_ms;
+
+    if (r->ops->connected())
+    {
+        r->connected_ms = elapsed?: 1;
+        r->resumed = r->phase == WIFI_RESUME_FAST;
+        r->phase = WIFI_RESUME_IDLE;
+        return false;
+    }
+
+    if (r->phase == WIFI_RESUME_FAST && elapsed >= WIFI_RESUME_TIMEOUT)
+    {
+        // AP moved or lease lost, don't try again next time
+        wifi_resume_invalidate(r);
+        r->phase = WIFI_RESUME_FULL;
+        r->ops->connect_full();
+    }
+    else if (elapsed >= WIFI_RESUME_GIVEUP)
+    {
+        r->phase = WIFI_RESUME_IDLE;
+        return false;
+    }
+
+    return true;
+}
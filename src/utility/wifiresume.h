@@ -0,0 +1,63 @@
+
+#ifndef __WIFIRESUME_H
+#define __WIFIRESUME_H
+
+// wifi_on() fast resume state machine
+// SDK calls are behind wifi_resume_ops, so this part does not depend on the SDK
+// (tools/wifi-resume-test runs it against a mock)
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define WIFI_RESUME_RTC_BLOCK   64      // user RTC memory, in 4-bytes blocks (64..191)
+#define WIFI_RESUME_TIMEOUT     1500    // ms before falling back to scan + DHCP
+#define WIFI_RESUME_GIVEUP      30000   // ms before stopping to wait for a connection
+#define WIFI_RESUME_POLL        10      // ms
+#define WIFI_RESUME_LEASE_MARGIN 60     // s, the lease is not reused this close to its end
+
+// saved by wifi_off() in RTC memory, survives deep sleep
+struct wifi_resume_state
+{
+    uint32_t crc;
+    uint8_t  channel;
+    uint8_t  bssid[6];
+    uint8_t  reserved;
+    uint32_t ip, gw, mask, dns;         // network order
+    uint32_t lease_s;                   // lease time left when saved, 0xffffffff: no end
+    uint32_t saved_s;                   // clock_s() when saved
+};
+
+struct wifi_resume_ops
+{
+    bool     (*rtc_read)     (void* data, size_t len);
+    bool     (*rtc_write)    (const void* data, size_t len);
+    bool     (*get_link)     (wifi_resume_state* state); // false when not connected
+    void     (*connect_fast) (const wifi_resume_state* state);
+    void     (*connect_full) ();
+    bool     (*connected)    ();
+    uint32_t (*now_ms)       ();
+    uint32_t (*clock_s)      ();        // seconds, keeps counting in deep sleep
+};
+
+enum wifi_resume_phase
+{
+    WIFI_RESUME_IDLE,
+    WIFI_RESUME_FAST,                   // direct connect with saved state
+    WIFI_RESUME_FULL,                   // scan, authentication, DHCP
+};
+
+struct wifi_resume
+{
+    const wifi_resume_ops* ops;
+    wifi_resume_phase phase;
+    uint32_t start_ms;
+    uint32_t connected_ms;              // wake-to-connected time, 0: not (yet) connected
+    bool resumed;                       // connected_ms was obtained with the saved state
+    uint32_t lease_s, lease_saved_s;    // lease of that state, saved again as is
+};
+
+void wifi_resume_save  (wifi_resume* r);                // before switching off
+void wifi_resume_start (wifi_resume* r);                // after switching on
+bool wifi_resume_poll  (wifi_resume* r);                // every WIFI_RESUME_POLL ms, false when done
+
+#endif // __WIFIRESUME_H
@@ -0,0 +1,41 @@
+// minimal host Print, enough for the NetDump decoders, see netdump-decode.cpp
+
+#ifndef __PRINT_H
+#define __PRINT_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+class Print
+{
+public:
+    virtual ~Print () { }
+    virtual size_t write (const uint8_t* data, size_t len) = 0;
+
+    size_t write (uint8_t c)                        { return write(&c, 1); }
+    size_t print (const char* s)                    { return write((const uint8_t*)s, strlen(s)); }
+    size_t print (const __FlashStringHelper* s)     { return print((const char*)s); }
+    size_t print (char c)                           { return write((uint8_t)c); }
+    size_t println ()                               { return print("\r\n"); }
+    size_t println (const char* s)                  { return print(s) + println(); }
+    size_t println (const __FlashStringHelper* s)   { return print(s) + println(); }
+
+    size_t printf (const char* format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char buf[128];
+        va_list arg;
+        va_start(arg, format);
+        int len = vsnprintf(buf, sizeof(buf), format, arg);
+        va_end(arg);
+        if (len < 0)
+            return 0;
+        return write((const uint8_t*)buf, (size_t)len < sizeof(buf)? len: sizeof(buf) - 1);
+    }
+};
+
+#endif // __PRINT_H
@@ -0,0 +1,2 @@
+// host build of the NetDump decoders, see ../netdump-decode.cpp
+#define LWIP_VERSION_MAJOR 2
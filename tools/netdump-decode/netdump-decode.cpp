@@ -0,0 +1,240 @@
+/*
+ netdump-decode: render a pcap file with the NetDump decoders, on a host
+
+ the file is memory-mapped, cut into record-aligned chunks, the chunks are
+ decoded by a pool of threads and printed in file order, packets/s are
+ reported on stderr
+
+ build (from the repository root, char is unsigned on the esp):
+     g++ -O2 -pthread -funsigned-char -Itools/netdump-decode -Isrc \
+         tools/netdump-decode/netdump-decode.cpp src/utility/NetDump.cpp src/utility/NetDumpHex.cpp src/utility/NetDumpCbor.cpp src/utility/chksum.c \
+         -o netdump-decode
+ usage:
+     netdump-decode [-j threads] [-x] [-c [-p bytes]] [-s] file.pcap
+     -x: also dump in hex (netDumpHex())
+     -c: cbor output (netDumpCbor(), read with tools/netdump_cbor.py), with -p bytes of payload
+     -s: each record is decoded from its own allocation of exactly its captured
+         length, to catch reads past it when built with -fsanitize=address
+ regression input: tools/netdump-decode/truncated.pcap (malformed and snapped
+ headers and tcp options, made by truncated.py), must decode in all modes:
+     for m in "" -x -c -s; do netdump-decode $m tools/netdump-decode/truncated.pcap; done
+
+ released to the public domain
+*/
+
+#include <NetDump.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CHUNK_SIZE  (4 << 20)   // bytes of records per chunk
+#define AHEAD       4           // decoded chunks waiting for output, per thread
+
+class StringPrint: public Print
+{
+public:
+    std::string s;
+    size_t write (const uint8_t* data, size_t len) override
+    {
+        s.append((const char*)data, len);
+        return len;
+    }
+};
+
+struct chunk
+{
+    size_t start, end;
+    size_t packets;
+    std::string text;
+    bool done;
+};
+
+static const uint8_t* file;
+static bool swapped;
+static bool hex;
+static bool cbor;
+static bool nanosec;
+static bool strict;
+static size_t payload;
+
+static uint32_t get32 (const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return swapped? __builtin_bswap32(v): v;
+}
+
+static void decode (chunk* c)
+{
+    StringPrint out;
+    out.s.reserve((c->end - c->start) * 2);
+    for (size_t p = c->start; p < c->end; )
+    {
+        size_t caplen = get32(file + p + 8);
+        const char* data = (const char*)file + p + 16;
+        std::vector<char> copy;
+        if (strict)
+        {
+            copy.assign(data, data + caplen);
+            copy.shrink_to_fit();
+            data = copy.data();
+        }
+        if (cbor)
+        {
+            uint64_t us = get32(file + p) * 1000000ULL + (nanosec? get32(file + p + 4) / 1000: get32(file + p + 4));
+            netDumpCbor(out, data, caplen, -1, -1, us, payload);
+        }
+        else
+        {
+            netDump(out, data, caplen);
+            if (hex)
+                netDumpHex(out, data, caplen);
+        }
+        p += 16 + caplen;
+        c->packets++;
+    }
+    c->text = std::move(out.s);
+}
+
+int main (int argc, char* argv[])
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    int opt;
+    while ((opt = getopt(argc, argv, "j:xcp:s")) != -1)
+        switch (opt)
+        {
+        case 'j': threads = atoi(optarg); break;
+        case 'x': hex = true; break;
+        case 'c': cbor = true; break;
+        case 'p': payload = atoi(optarg); break;
+        case 's': strict = true; break;
+        default: fprintf(stderr, "usage: %s [-j threads] [-x] [-c [-p bytes]] [-s] file.pcap\n", argv[0]); return 1;
+        }
+    if (optind != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-j threads] [-x] [-c [-p bytes]] [-s] file.pcap\n", argv[0]);
+        return 1;
+    }
+    if (threads < 1)
+        threads = 1;
+
+    int fd = open(argv[optind], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    size_t size = st.st_size;
+    if (size < 24)
+    {
+        fprintf(stderr, "%s: not a pcap file\n", argv[optind]);
+        return 1;
+    }
+    file = (const uint8_t*)mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (file == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+    madvise((void*)file, size, MADV_SEQUENTIAL);
+
+    // pcap-savefile(5) preamble, micro or nanosecond timestamps
+    uint32_t magic;
+    memcpy(&magic, file, 4);
+    swapped = magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1;
+    nanosec = magic == 0xa1b23c4d || magic == 0x4d3cb2a1;
+    if (!swapped && magic != 0xa1b2c3d4 && magic != 0xa1b23c4d)
+    {
+        fprintf(stderr, "%s: not a pcap file\n", argv[optind]);
+        return 1;
+    }
+    if (get32(file + 20) != 1)
+        fprintf(stderr, "%s: link type %u is not ethernet\n", argv[optind], get32(file + 20));
+
+    // record-aligned chunks: only record headers are visited here
+    std::vector<chunk> chunks;
+    size_t p = 24;
+    while (p < size)
+    {
+        chunk c = { p, p, 0, std::string(), false };
+        while (p + 16 <= size && p - c.start < CHUNK_SIZE)
+        {
+            size_t next = p + 16 + get32(file + p + 8);
+            if (next > size)
+                // truncated last record
+                break;
+            p = next;
+        }
+        c.end = p;
+        if (c.end == c.start)
+            break;
+        chunks.push_back(std::move(c));
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::mutex lock;
+    std::condition_variable cond;
+    std::atomic<size_t> next(0);
+    size_t written = 0;
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++)
+        pool.emplace_back([&]
+        {
+            for (;;)
+            {
+                size_t i = next++;
+                if (i >= chunks.size())
+                    return;
+                {
+                    // do not run too far ahead of the output
+                    std::unique_lock<std::mutex> l(lock);
+                    cond.wait(l, [&] { return i < written + AHEAD * threads; });
+                }
+                decode(&chunks[i]);
+                std::lock_guard<std::mutex> l(lock);
+                chunks[i].done = true;
+                cond.notify_all();
+            }
+        });
+
+    size_t packets = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        {
+            std::unique_lock<std::mutex> l(lock);
+            cond.wait(l, [&] { return chunks[i].done; });
+        }
+        fwrite(chunks[i].text.data(), 1, chunks[i].text.size(), stdout);
+        packets += chunks[i].packets;
+        std::string().swap(chunks[i].text);
+        std::lock_guard<std::mutex> l(lock);
+        written = i + 1;
+        cond.notify_all();
+    }
+
+    for (auto& t: pool)
+        t.join();
+    fflush(stdout);
+
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    fprintf(stderr, "%zu packets in %.3fs: %.0f packets/s (%u threads)\n",
+        packets, s, s > 0? packets / s: 0., threads);
+
+    munmap((void*)file, size);
+    close(fd);
+    return 0;
+}
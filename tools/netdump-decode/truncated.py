@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+
+# writes truncated.pcap, the netdump-decode regression input:
+# records whose headers (ip, tcp, tcp options, udp, icmp, arp) claim more
+# than what was captured, or are malformed, the decoders must stop at caplen
+# usage: truncated.py > tools/netdump-decode/truncated.pcap
+
+import struct
+import sys
+
+ETH_IP = b"\x02\x00\x00\x00\x00\x01" + b"\x5c\xcf\x7f\x00\x00\x01" + b"\x08\x00"
+ETH_ARP = b"\xff" * 6 + b"\x02\x00\x00\x00\x00\x01" + b"\x08\x06"
+
+def ip (proto, payload, ihl=5, totlen=None):
+    opts = b"\x01" * (ihl * 4 - 20 if ihl > 5 else 0)
+    hdr = struct.pack("!BBHHHBBH4s4s", 0x40 | ihl, 0, totlen if totlen is not None else 20 + len(opts) + len(payload),
+                      1, 0x4000, 64, proto, 0, bytes([10, 0, 0, 1]), bytes([10, 0, 0, 10])) + opts
+    # header checksum, only the tcp/udp/icmp ones are left wrong
+    s = sum(struct.unpack("!%dH" % (len(hdr) // 2), hdr))
+    while s >> 16:
+        s = (s & 0xffff) + (s >> 16)
+    return hdr[:10] + struct.pack("!H", ~s & 0xffff) + hdr[12:] + payload
+
+def tcp (options=b"", doff=None, payload=b""):
+    if doff is None:
+        doff = 5 + (len(options) + 3) // 4
+    return struct.pack("!HHIIHHHH", 443, 49152, 1000, 2000, (doff << 12) | 0x18, 5840, 0, 0) + options + payload
+
+records = [
+    # tcp options
+    ETH_IP + ip(6, tcp(b"\x03\x00\x01\x01")),                       # option length 0 (was an endless loop)
+    ETH_IP + ip(6, tcp(b"\x08\x01\x01\x01")),                       # option length 1
+    ETH_IP + ip(6, tcp(b"\x01\x01\x08\x28")),                       # option longer than the header
+    ETH_IP + ip(6, tcp(b"\x01\x01\x01\x02")),                       # option length byte missing
+    ETH_IP + ip(6, tcp(b"\x02\x02\x01\x01")),                       # mss of length 2
+    ETH_IP + ip(6, tcp(b"\x02\x04\x05\xb4" + b"\x01" * 36)),       # 40 bytes of options...
+    (ETH_IP + ip(6, tcp(b"\x02\x04\x05\xb4" + b"\x01" * 36)))[:14 + 20 + 22],  # ...captured: 2
+    (ETH_IP + ip(6, tcp(b"\x02\x04\x05\xb4")))[:14 + 20 + 23],      # mss value snapped
+    ETH_IP + ip(6, tcp(doff=15)),                                   # data offset beyond the packet
+    ETH_IP + ip(6, tcp(doff=2)),                                    # data offset below 5
+    ETH_IP + ip(6, tcp(), totlen=10),                               # ip total length below the headers
+    # snapped headers
+    (ETH_IP + ip(6, tcp()))[:14 + 20 + 15],
+    (ETH_IP + ip(6, tcp(), ihl=15))[:14 + 60 + 10],                 # ip options, tcp snapped
+    (ETH_IP + ip(17, struct.pack("!HHHH", 53, 1024, 8, 0)))[:14 + 20 + 7],
+    (ETH_IP + ip(17, struct.pack("!HHHH", 53, 1024, 8, 0), ihl=15))[:14 + 60 + 4],
+    (ETH_IP + ip(1, b"\x08\x00\x00\x00"))[:14 + 20],
+    (ETH_IP + ip(1, b"\x08\x00\x00\x00", ihl=6))[:14 + 24],
+    (ETH_IP + ip(2, b"\x11\x00\x00\x00"))[:14 + 20],
+    ETH_IP + ip(6, tcp(), ihl=2),                                   # ip header length below 20
+    ETH_IP[:10],
+    ETH_IP,
+    (ETH_IP + ip(6, tcp()))[:14 + 19],
+    (ETH_ARP + b"\x00\x01\x08\x00\x06\x04\x00\x01" + b"\x00" * 20)[:14 + 27],
+    b"",
+]
+
+out = sys.stdout.buffer
+out.write(struct.pack("<IHHiIII", 0xa1b2c3d4, 2, 4, 0, 0, 1536, 1))
+for i, r in enumerate(records):
+    out.write(struct.pack("<IIII", 1700000000, i, len(r), len(r)) + r)
@@ -0,0 +1,253 @@
+/*
+ netdump-filter-bench: src/NetDumpFilter.h against the same tests written by
+ hand, on a host
+
+ random frames (ipv4 tcp/udp/icmp with and without ip options, fragments,
+ arp, ipv6, snapped at any length) go through a few composed filters and
+ their hand-written equivalents, which check each header once:
+ - test: both must agree on every frame
+ - bench: ns per frame for each, the filters should not be slower
+
+ build (from the repository root, char is unsigned on the esp):
+     g++ -O2 -Wall -Wextra -funsigned-char -Itools/netdump-decode -Isrc \
+         tools/netdump-filter-bench/netdump-filter-bench.cpp -o netdump-filter-bench
+ usage:
+     netdump-filter-bench [test|bench] [-n frames]
+
+ released to the public domain
+*/
+
+#include <NetDumpFilter.h>
+
+#include <chrono>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace netdump_filter;
+
+/////////////////////
+// filters, and the same by hand
+
+constexpr auto https_or_arp = (Ipv4 && Tcp && DstPort<443>) || Arp;
+constexpr auto dns_not_gw = Udp && Port<53> && !SrcHost<ip(10, 0, 0, 1)>;
+constexpr auto web_syn = Tcp && TcpFlags<2> && (DstPort<80> || DstPort<443>);
+
+static bool __attribute__((noinline)) filter_https_or_arp (const char* d, size_t size) { return match(https_or_arp, d, size); }
+static bool __attribute__((noinline)) filter_dns_not_gw (const char* d, size_t size) { return match(dns_not_gw, d, size); }
+static bool __attribute__((noinline)) filter_web_syn (const char* d, size_t size) { return match(web_syn, d, size); }
+
+// tcp or udp, first fragment: transport header offset, 0 if not
+static size_t ports_at (const char* d, size_t size)
+{
+    if (size < ETH_HDR_LEN + 20 || !netDump_is_IPv4(d))
+        return 0;
+    size_t l4 = ETH_HDR_LEN + netDump_getIpHdrLen(d);
+    if (   (!netDump_is_TCP(d) && !netDump_is_UDP(d))
+        || (ntoh16(d + ETH_HDR_LEN + 6) & 0x1fff)
+        || size < l4 + 4)
+        return 0;
+    return l4;
+}
+
+static bool __attribute__((noinline)) hand_https_or_arp (const char* d, size_t size)
+{
+    if (size >= ETH_HDR_LEN + 28 && netDump_is_ARP(d))
+        return true;
+    size_t l4 = ports_at(d, size);
+    return l4 && netDump_is_TCP(d) && ntoh16(d + l4 + 2) == 443;
+}
+
+static bool __attribute__((noinline)) hand_dns_not_gw (const char* d, size_t size)
+{
+    size_t l4 = ports_at(d, size);
+    return l4 && netDump_is_UDP(d)
+        && (ntoh16(d + l4) == 53 || ntoh16(d + l4 + 2) == 53)
+        && ntoh32(d + ETH_HDR_LEN + 12) != ip(10, 0, 0, 1);
+}
+
+static bool __attribute__((noinline)) hand_web_syn (const char* d, size_t size)
+{
+    size_t l4 = ports_at(d, size);
+    if (!l4 || !netDump_is_TCP(d) || size < l4 + 14 || !(d[l4 + 13] & 2))
+        return false;
+    uint16_t port = ntoh16(d + l4 + 2);
+    return port == 80 || port == 443;
+}
+
+typedef bool (*test_fn) (const char* d, size_t size);
+
+static const struct
+{
+    const char* name;
+    test_fn filter;
+    test_fn hand;
+} tests [] =
+{
+    { "(Ipv4 && Tcp && DstPort<443>) || Arp", filter_https_or_arp, hand_https_or_arp },
+    { "Udp && Port<53> && !SrcHost<gw>", filter_dns_not_gw, hand_dns_not_gw },
+    { "Tcp && TcpFlags<SYN> && (DstPort<80> || DstPort<443>)", filter_web_syn, hand_web_syn },
+};
+
+/////////////////////
+// frames
+
+#define FRAME_MAX 128
+
+struct frame
+{
+    char data[FRAME_MAX];
+    size_t size;
+};
+
+static uint16_t pick (const uint16_t* values, size_t count)
+{
+    return values[random() % count];
+}
+
+static void random_frame (frame* f)
+{
+    static const uint16_t ethtypes [] = { 0x0800, 0x0800, 0x0800, 0x0800, 0x0806, 0x86dd };
+    static const uint16_t protos [] = { 6, 6, 17, 17, 1, 2 };
+    static const uint16_t ports [] = { 53, 80, 443, 1024, 49152 };
+
+    for (size_t i = 0; i < FRAME_MAX; i++)
+        f->data[i] = random();
+    char* d = f->data;
+    uint16_t ethtype = pick(ethtypes, sizeof(ethtypes) / sizeof(ethtypes[0]));
+    d[12] = ethtype >> 8;
+    d[13] = ethtype;
+
+    size_t l4 = ETH_HDR_LEN + 20;
+    if (ethtype == 0x0800)
+    {
+        int ihl = random() % 4? 5: 5 + random() % 11;
+        l4 = ETH_HDR_LEN + ihl * 4;
+        d[ETH_HDR_LEN] = 0x40 | ihl;
+        d[ETH_HDR_LEN + 6] = random() % 8? 0x40: random();     // DF, or any fragment
+        d[ETH_HDR_LEN + 7] = d[ETH_HDR_LEN + 6] == 0x40? 0: random();
+        d[ETH_HDR_LEN + 9] = pick(protos, sizeof(protos) / sizeof(protos[0]));
+        uint32_t src = random() % 4? ip(10, 0, 0, 1 + random() % 3): random();
+        for (int i = 0; i < 4; i++)
+            d[ETH_HDR_LEN + 12 + i] = src >> (24 - 8 * i);
+        uint16_t sport = pick(ports, sizeof(ports) / sizeof(ports[0]));
+        uint16_t dport = pick(ports, sizeof(ports) / sizeof(ports[0]));
+        d[l4] = sport >> 8;
+        d[l4 + 1] = sport;
+        d[l4 + 2] = dport >> 8;
+        d[l4 + 3] = dport;
+    }
+
+    // mostly whole headers, sometimes snapped anywhere
+    size_t whole = l4 + 20;
+    f->size = random() % 8? whole + random() % (FRAME_MAX - whole + 1): random() % (whole + 1);
+}
+
+/////////////////////
+// checks
+
+static int failed;
+
+#define CHECK(cond, ...) \
+    do { if (!(cond)) { failed++; printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+static void check (const std::vector<frame>& frames)
+{
+    for (const auto& t: tests)
+    {
+        size_t matched = 0, mismatches = 0;
+        for (const frame& f: frames)
+        {
+            bool filter = t.filter(f.data, f.size);
+            bool hand = t.hand(f.data, f.size);
+            matched += filter;
+            if (filter != hand && mismatches++ < 4)
+                CHECK(filter == hand, "%s: size %zu ethtype 0x%04x proto %u: filter %d, by hand %d",
+                    t.name, f.size, ntoh16(f.data + 12), f.data[ETH_HDR_LEN + 9], filter, hand);
+        }
+        // the frames must exercise both outcomes
+        CHECK(matched && matched < frames.size(), "%s: %zu/%zu matched", t.name, matched, frames.size());
+    }
+}
+
+static volatile size_t sink;
+
+static double ns_per_frame (test_fn fn, const std::vector<frame>& frames, int rounds)
+{
+    size_t sum = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        for (const frame& f: frames)
+            sum += fn(f.data, f.size);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    sink = sum;
+    return ns / rounds / frames.size();
+}
+
+// best of 5, interleaved
+static void best_of (const std::vector<frame>& frames, test_fn filter, test_fn hand, double* filter_ns, double* hand_ns)
+{
+    const int rounds = 20;
+    *filter_ns = *hand_ns = 1e9;
+    for (int i = 0; i < 5; i++)
+    {
+        double ns = ns_per_frame(filter, frames, rounds);
+        if (ns < *filter_ns)
+            *filter_ns = ns;
+        ns = ns_per_frame(hand, frames, rounds);
+        if (ns < *hand_ns)
+            *hand_ns = ns;
+    }
+}
+
+static void bench (const std::vector<frame>& frames)
+{
+    // mixed: mostly branch mispredictions, matching only: the cost of the
+    // checks themselves (every layer tested, no misprediction)
+    printf("%-54s %17s %17s\n", "ns/frame", "mixed", "matching only");
+    printf("%-54s %8s %8s %8s %8s\n", "", "filter", "by hand", "filter", "by hand");
+    for (const auto& t: tests)
+    {
+        std::vector<frame> matching;
+        for (const frame& f: frames)
+            if (t.hand(f.data, f.size))
+                matching.push_back(f);
+        double mixed_filter, mixed_hand, matching_filter, matching_hand;
+        best_of(frames, t.filter, t.hand, &mixed_filter, &mixed_hand);
+        best_of(matching, t.filter, t.hand, &matching_filter, &matching_hand);
+        printf("%-54s %8.2f %8.2f %8.2f %8.2f\n", t.name, mixed_filter, mixed_hand, matching_filter, matching_hand);
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    size_t count = 100000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+        switch (opt)
+        {
+        case 'n': count = atol(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [test|bench] [-n frames]\n", argv[0]);
+            return 1;
+        }
+    const char* mode = optind < argc? argv[optind]: "test";
+
+    srandom(1);
+    std::vector<frame> frames(count);
+    for (frame& f: frames)
+        random_frame(&f);
+
+    if (!strcmp(mode, "bench"))
+    {
+        bench(frames);
+        return 0;
+    }
+
+    check(frames);
+    printf("netdump-filter-bench: %s\n", failed? "FAILED": "ok");
+    return failed? 1: 0;
+}
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+
+# decoder for netDumpCbor() output: one cbor map per packet
+# as a library:
+#     import netdump_cbor
+#     for packet in netdump_cbor.packets(stream):
+#         print(packet["src_ip"], packet.get("dst_port"))
+# as a tool (json lines):
+#     nc esp-ip-address port | netdump_cbor.py
+#     netdump-decode -c file.pcap | netdump_cbor.py
+
+import ipaddress
+import json
+import struct
+import sys
+
+# keep in sync with src/NetDump.h (NETDUMP_CBOR_*)
+KEYS = {
+    0: "time_us",
+    1: "out",
+    2: "netif",
+    3: "size",
+    4: "dst_mac",
+    5: "src_mac",
+    6: "ethtype",
+    7: "src_ip",
+    8: "dst_ip",
+    9: "proto",
+    10: "len",
+    11: "src_port",
+    12: "dst_port",
+    13: "flags",
+    14: "seq",
+    15: "ack",
+    16: "window",
+    17: "usr_len",
+    18: "icmp_type",
+    19: "arp_op",
+    20: "arp_mac",
+    21: "bad_sums",
+    22: "payload",
+}
+MACS = ("dst_mac", "src_mac", "arp_mac")
+IPS = ("src_ip", "dst_ip")
+BREAK = object()
+
+
+class Reader:
+    def __init__(self, stream):
+        self.stream = stream
+
+    def read(self, n):
+        data = self.stream.read(n)
+        if len(data) != n:
+            raise EOFError
+        return data
+
+    def head(self):
+        b = self.read(1)[0]
+        major, info = b >> 5, b & 0x1f
+        if info < 24:
+            return major, info
+        if info <= 27:
+            size = 1 << (info - 24)
+            return major, int.from_bytes(self.read(size), "big")
+        if info == 31:
+            return major, None
+        raise ValueError("bad cbor item 0x%02x" % b)
+
+    def item(self):
+        major, value = self.head()
+        if major == 0:
+            return value
+        if major == 1:
+            return -1 - value
+        if major in (2, 3):
+            if value is None:
+                chunks = []
+                while True:
+                    chunk = self.item()
+                    if chunk is BREAK:
+                        break
+                    chunks.append(chunk)
+                data = b"".join(c if isinstance(c, bytes) else c.encode() for c in chunks)
+            else:
+                data = self.read(value)
+            return data if major == 2 else data.decode()
+        if major == 4:
+            items = []
+            while value is None or len(items) < value:
+                item = self.item()
+                if item is BREAK:
+                    break
+                items.append(item)
+            return items
+        if major == 5:
+            items = {}
+            while value is None or len(items) < value:
+                key = self.item()
+                if key is BREAK:
+                    break
+                items[key] = self.item()
+            return items
+        if major == 7:
+            if value is None:
+                return BREAK
+            if value in (20, 21):
+                return value == 21
+            if value == 22:
+                return None
+        raise ValueError("unsupported cbor item (major %d)" % major)
+
+
+def packet(fields):
+    """cbor map with integer keys -> dict with names and readable addresses"""
+    p = {}
+    for key, value in fields.items():
+        name = KEYS.get(key, key)
+        if name in MACS:
+            value = ":".join("%02x" % b for b in value)
+        elif name in IPS:
+            value = str(ipaddress.ip_address(value))
+        p[name] = value
+    return p
+
+
+def packets(stream):
+    """generator of decoded packets from a binary stream"""
+    reader = Reader(stream)
+    while True:
+        try:
+            fields = reader.item()
+        except EOFError:
+            return
+        yield packet(fields)
+
+
+if __name__ == "__main__":
+    for p in packets(sys.stdin.buffer):
+        if "payload" in p:
+            p["payload"] = p["payload"].hex()
+        print(json.dumps(p))
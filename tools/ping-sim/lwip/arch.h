@@ -0,0 +1,27 @@
+// host stand-in for the parts of lwIP used by ping.c, see ../ping-sim.cpp
+
+#ifndef __SIM_LWIP_ARCH_H
+#define __SIM_LWIP_ARCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t  u8_t;
+typedef int8_t   s8_t;
+typedef uint16_t u16_t;
+typedef int16_t  s16_t;
+typedef uint32_t u32_t;
+typedef int32_t  s32_t;
+typedef uint64_t u64_t;
+typedef s8_t     err_t;
+
+#define ERR_OK      0
+#define ERR_MEM     -1
+#define ERR_RTE     -4
+
+#define LWIP_UNUSED_ARG(x)  (void)(x)
+#define LWIP_ASSERT(m, x)   (void)(x)
+#define LWIP_DBG_ON         0x80
+
+#endif // __SIM_LWIP_ARCH_H
@@ -0,0 +1,15 @@
+// host stand-in, see ../ping-sim.cpp
+
+#ifndef __SIM_LWIP_ETHARP_H
+#define __SIM_LWIP_ETHARP_H
+
+#include "netif.h"
+
+struct eth_addr { u8_t addr[6]; };
+
+#ifdef __cplusplus
+extern "C"
+#endif
+s8_t etharp_find_addr (struct netif* netif, const ip4_addr_t* ipaddr, struct eth_addr** eth_ret, const ip4_addr_t** ip_ret);
+
+#endif // __SIM_LWIP_ETHARP_H
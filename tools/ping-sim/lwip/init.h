@@ -0,0 +1,2 @@
+// host stand-in, see ../ping-sim.cpp
+#define LWIP_VERSION_MAJOR 2
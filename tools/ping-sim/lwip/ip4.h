@@ -0,0 +1,13 @@
+// host stand-in, see ../ping-sim.cpp
+
+#ifndef __SIM_LWIP_IP4_H
+#define __SIM_LWIP_IP4_H
+
+#include "netif.h"
+
+#ifdef __cplusplus
+extern "C"
+#endif
+struct netif* ip4_route (const ip4_addr_t* dest);
+
+#endif // __SIM_LWIP_IP4_H
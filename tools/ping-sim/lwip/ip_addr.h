@@ -0,0 +1,35 @@
+// host stand-in (ipv4 only), see ../ping-sim.cpp
+
+#ifndef __SIM_LWIP_IP_ADDR_H
+#define __SIM_LWIP_IP_ADDR_H
+
+#include "opt.h"
+
+typedef struct ip4_addr { u32_t addr; } ip4_addr_t;
+typedef ip4_addr_t ip_addr_t;
+
+#define IPADDR4_INIT(u)                 { u }
+#define ip_addr_copy(dest, src)         ((dest) = (src))
+#define ip_addr_cmp(a, b)               ((a)->addr == (b)->addr)
+#define ip_2_ip4(a)                     (a)
+#define ip_addr_set_ip4_u32(a, u)       ((a)->addr = (u))
+#define ip_addr_get_ip4_u32(a)          ((a)->addr)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern const ip_addr_t ip_addr_any;
+#define IP_ADDR_ANY (&ip_addr_any)
+
+static inline u16_t lwip_htons (u16_t x) { return __builtin_bswap16(x); }
+static inline u32_t lwip_htonl (u32_t x) { return __builtin_bswap32(x); }
+#define lwip_ntohs lwip_htons
+#define lwip_ntohl lwip_htonl
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIM_LWIP_IP_ADDR_H
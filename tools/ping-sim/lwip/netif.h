@@ -0,0 +1,16 @@
+// host stand-in, see ../ping-sim.cpp
+
+#ifndef __SIM_LWIP_NETIF_H
+#define __SIM_LWIP_NETIF_H
+
+#include "pbuf.h"
+
+struct netif
+{
+    ip4_addr_t ip_addr;
+    ip4_addr_t netmask;
+    ip4_addr_t gw;
+    u16_t mtu;
+};
+
+#endif // __SIM_LWIP_NETIF_H
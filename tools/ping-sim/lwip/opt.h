@@ -0,0 +1,19 @@
+// host stand-in, see ../ping-sim.cpp
+
+#ifndef __SIM_LWIP_OPT_H
+#define __SIM_LWIP_OPT_H
+
+#include "arch.h"
+
+#define LWIP_RAW        1
+#define LWIP_ARP        1
+#define IP_PROTO_ICMP   1
+
+// lwIP's defaults (also the esp8266's)
+#ifndef ARP_TABLE_SIZE
+#define ARP_TABLE_SIZE  10
+#endif
+#define ARP_MAXAGE      300     // seconds
+#define ARP_MAXPENDING  5       // seconds
+
+#endif // __SIM_LWIP_OPT_H
@@ -0,0 +1,33 @@
+// host stand-in, see ../ping-sim.cpp
+
+#ifndef __SIM_LWIP_PBUF_H
+#define __SIM_LWIP_PBUF_H
+
+#include "ip_addr.h"
+
+#define PBUF_IP_HLEN 20
+
+typedef enum { PBUF_TRANSPORT, PBUF_IP, PBUF_LINK, PBUF_RAW } pbuf_layer;
+typedef enum { PBUF_RAM, PBUF_ROM, PBUF_REF, PBUF_POOL } pbuf_type;
+
+struct pbuf
+{
+    struct pbuf* next;
+    void* payload;
+    u16_t tot_len;
+    u16_t len;
+};
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+struct pbuf* pbuf_alloc (pbuf_layer layer, u16_t length, pbuf_type type);
+u8_t pbuf_free (struct pbuf* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIM_LWIP_PBUF_H
@@ -0,0 +1,26 @@
+// host stand-in, see ../ping-sim.cpp
+
+#ifndef __SIM_LWIP_RAW_H
+#define __SIM_LWIP_RAW_H
+
+#include "pbuf.h"
+
+struct raw_pcb;
+typedef u8_t (*raw_recv_fn) (void* arg, struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* addr);
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+struct raw_pcb* raw_new (u8_t proto);
+void  raw_remove (struct raw_pcb* pcb);
+void  raw_recv   (struct raw_pcb* pcb, raw_recv_fn recv, void* recv_arg);
+err_t raw_bind   (struct raw_pcb* pcb, const ip_addr_t* ipaddr);
+err_t raw_sendto (struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* ipaddr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIM_LWIP_RAW_H
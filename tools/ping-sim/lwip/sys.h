@@ -0,0 +1,23 @@
+// host stand-in, see ../ping-sim.cpp
+
+#ifndef __SIM_LWIP_SYS_H
+#define __SIM_LWIP_SYS_H
+
+#include "arch.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+u32_t sys_now (void);
+u32_t sim_now_us (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+// ping.c's microsecond clock
+#define PING_NOW_US() sim_now_us()
+
+#endif // __SIM_LWIP_SYS_H
@@ -0,0 +1,22 @@
+// host stand-in, see ../ping-sim.cpp
+
+#ifndef __SIM_LWIP_TIMEOUTS_H
+#define __SIM_LWIP_TIMEOUTS_H
+
+#include "arch.h"
+
+typedef void (*sys_timeout_handler) (void* arg);
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+void sys_timeout   (u32_t msecs, sys_timeout_handler handler, void* arg);
+void sys_untimeout (sys_timeout_handler handler, void* arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIM_LWIP_TIMEOUTS_H
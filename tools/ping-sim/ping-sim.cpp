@@ -0,0 +1,829 @@
+/*
+ ping-sim: src/utility/ping.c against a simulated lwIP, on a host
+
+ the clock is virtual (sys_now(), PING_NOW_US()), sys_timeout() timers and
+ packets are events on it, so hours of probing run in milliseconds.
+ the esp is 10.0.0.10/24 behind a scripted link: drop, delay, jitter,
+ duplicate and reorder replies, bottleneck bandwidth, and an ARP table
+ that expires and recycles entries like lwIP's etharp.
+
+ build (from the repository root):
+     g++ -O2 -Itools/ping-sim -Isrc \
+         -x c src/utility/ping.c src/utility/chksum.c -x c++ tools/ping-sim/ping-sim.cpp \
+         -o ping-sim
+ usage:
+     ping-sim [test]                 checks ping-alive, sweep and train, exit status 1 on failure
+     ping-sim bench                  cpu time per probe
+     ping-sim [link] alive hours     ping-alive to the gateway
+     ping-sim [link] sweep           sweep of 10.0.0.1-254 (alive: .1 .5 .77 .200 .254, ARP only: .9)
+     ping-sim [link] train size count
+     link: -d drop -u duplicate -r reorder (probabilities, on replies)
+           -l delay_ms (one way) -j jitter_ms -w bandwidth_kbps -s seed
+
+ released to the public domain
+*/
+
+#include <map>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+extern "C"
+{
+#include <lwip/raw.h>
+#include <lwip/icmp.h>
+#include <lwip/ip4.h>
+#include <lwip/etharp.h>
+#include <lwip/sys.h>
+#include <lwip/timeouts.h>
+#include <utility/ping.h>
+#include <utility/trace.h>
+}
+
+#define NET         0x0a000000  // 10.0.0.0/24, host order
+#define DEVICE      (NET | 10)
+#define GATEWAY     (NET | 1)
+
+#define HOST_ICMP   1           // answers echo requests (and ARP)
+#define HOST_ARP    2           // answers ARP only
+
+/////////////////////
+// scripted link
+
+struct link_script
+{
+    double   drop;              // probabilities, applied to replies
+    double   duplicate;
+    double   reorder;           // held back by reorder_us
+    uint32_t delay_us;          // one way
+    uint32_t jitter_us;
+    uint32_t reorder_us;
+    uint32_t bandwidth_bps;     // bottleneck toward the hosts, 0: none
+    bool     down;              // nothing answers
+};
+
+static link_script script;
+static uint8_t hosts[256];
+static uint64_t rng = 1;
+
+static double random01 ()
+{
+    // xorshift64*, reproducible runs
+    rng ^= rng >> 12;
+    rng ^= rng << 25;
+    rng ^= rng >> 27;
+    return ((rng * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/////////////////////
+// virtual clock and events
+
+enum event_type { EVENT_TIMER, EVENT_REPLY, EVENT_ARP };
+
+struct event
+{
+    event_type type;
+    sys_timeout_handler handler;
+    void* arg;
+    uint32_t addr;              // host order: reply source, resolved address
+    std::vector<uint8_t> data;  // reply: ip header + icmp
+};
+
+static uint64_t now_us;
+static std::multimap<uint64_t, event> events;   // same time: insertion order
+
+extern "C" u32_t sys_now ()
+{
+    return now_us / 1000;
+}
+
+extern "C" u32_t sim_now_us ()
+{
+    return now_us;
+}
+
+extern "C" void sys_timeout (u32_t msecs, sys_timeout_handler handler, void* arg)
+{
+    event e = { EVENT_TIMER, handler, arg, 0, { } };
+    events.emplace(now_us + msecs * 1000ULL, std::move(e));
+}
+
+extern "C" void sys_untimeout (sys_timeout_handler handler, void* arg)
+{
+    // like lwIP, the first match only
+    for (auto i = events.begin(); i != events.end(); ++i)
+        if (i->second.type == EVENT_TIMER && i->second.handler == handler && i->second.arg == arg)
+        {
+            events.erase(i);
+            return;
+        }
+}
+
+/////////////////////
+// pbufs, raw pcbs, route
+
+static long pbufs;              // outstanding
+static int  pbuf_failures;      // next allocations to fail
+
+extern "C" struct pbuf* pbuf_alloc (pbuf_layer layer, u16_t length, pbuf_type type)
+{
+    (void)layer;
+    (void)type;
+    if (pbuf_failures)
+    {
+        pbuf_failures--;
+        return nullptr;
+    }
+    struct pbuf* p = (struct pbuf*)malloc(sizeof(struct pbuf) + length);
+    p->next = nullptr;
+    p->payload = p + 1;
+    p->tot_len = p->len = length;
+    pbufs++;
+    return p;
+}
+
+extern "C" u8_t pbuf_free (struct pbuf* p)
+{
+    free(p);
+    pbufs--;
+    return 1;
+}
+
+struct raw_pcb
+{
+    raw_recv_fn recv;
+    void* arg;
+};
+
+static std::vector<raw_pcb*> pcbs;
+const ip_addr_t ip_addr_any = { 0 };
+
+extern "C" struct raw_pcb* raw_new (u8_t proto)
+{
+    (void)proto;
+    raw_pcb* pcb = new raw_pcb { nullptr, nullptr };
+    // lwIP puts new pcbs first
+    pcbs.insert(pcbs.begin(), pcb);
+    return pcb;
+}
+
+extern "C" void raw_remove (struct raw_pcb* pcb)
+{
+    for (auto i = pcbs.begin(); i != pcbs.end(); ++i)
+        if (*i == pcb)
+        {
+            pcbs.erase(i);
+            delete pcb;
+            return;
+        }
+}
+
+extern "C" void raw_recv (struct raw_pcb* pcb, raw_recv_fn recv, void* recv_arg)
+{
+    pcb->recv = recv;
+    pcb->arg = recv_arg;
+}
+
+extern "C" err_t raw_bind (struct raw_pcb* pcb, const ip_addr_t* ipaddr)
+{
+    (void)pcb;
+    (void)ipaddr;
+    return ERR_OK;
+}
+
+static struct netif sim_netif;
+
+extern "C" struct netif* ip4_route (const ip4_addr_t* dest)
+{
+    (void)dest;
+    return &sim_netif;
+}
+
+/////////////////////
+// ARP table, lwIP's etharp policy:
+// pending entries keep the last packet and live ARP_MAXPENDING seconds,
+// stable ones ARP_MAXAGE seconds, a new entry recycles the oldest stable
+// one first, then the oldest pending one
+
+enum arp_state { ARP_EMPTY, ARP_PENDING, ARP_STABLE };
+
+struct arp_entry
+{
+    arp_state state;
+    uint32_t ip;                // host order
+    uint64_t ctime_us;
+    std::vector<uint8_t> q;     // pending: echo request waiting for the answer
+};
+
+static arp_entry arp_table[ARP_TABLE_SIZE];
+static long arp_evicted;
+
+static int arp_find (uint32_t ip)
+{
+    for (int i = 0; i < ARP_TABLE_SIZE; i++)
+        if (arp_table[i].state != ARP_EMPTY && arp_table[i].ip == ip)
+            return i;
+    return -1;
+}
+
+static int arp_new (uint32_t ip)
+{
+    int empty = -1, stable = -1, pending = -1, queued = -1;
+    for (int i = 0; i < ARP_TABLE_SIZE; i++)
+    {
+        arp_entry& e = arp_table[i];
+        if (e.state == ARP_EMPTY)
+        {
+            if (empty < 0)
+                empty = i;
+        }
+        else if (e.state == ARP_STABLE)
+        {
+            if (stable < 0 || e.ctime_us < arp_table[stable].ctime_us)
+                stable = i;
+        }
+        else if (e.q.empty())
+        {
+            if (pending < 0 || e.ctime_us < arp_table[pending].ctime_us)
+                pending = i;
+        }
+        else if (queued < 0 || e.ctime_us < arp_table[queued].ctime_us)
+            queued = i;
+    }
+    int i = empty >= 0? empty: stable >= 0? stable: pending >= 0? pending: queued;
+    if (i != empty)
+        arp_evicted++;
+    arp_table[i].state = ARP_PENDING;
+    arp_table[i].ip = ip;
+    arp_table[i].ctime_us = now_us;
+    arp_table[i].q.clear();
+    return i;
+}
+
+static void arp_expire ()
+{
+    for (auto& e: arp_table)
+        if (   (e.state == ARP_STABLE && now_us - e.ctime_us >= ARP_MAXAGE * 1000000ULL)
+            || (e.state == ARP_PENDING && now_us - e.ctime_us >= ARP_MAXPENDING * 1000000ULL))
+        {
+            e.state = ARP_EMPTY;
+            e.q.clear();
+        }
+}
+
+extern "C" s8_t etharp_find_addr (struct netif* netif, const ip4_addr_t* ipaddr, struct eth_addr** eth_ret, const ip4_addr_t** ip_ret)
+{
+    (void)netif;
+    static struct eth_addr mac;
+    int i = arp_find(lwip_ntohl(ipaddr->addr));
+    if (i < 0 || arp_table[i].state != ARP_STABLE)
+        return -1;
+    *eth_ret = &mac;
+    *ip_ret = ipaddr;
+    return i;
+}
+
+/////////////////////
+// the wire
+
+static long requests;           // echo requests on the wire
+static uint64_t link_free_us;   // bottleneck busy until
+
+static void transmit (uint32_t dst, const std::vector<uint8_t>& icmp)
+{
+    requests++;
+    uint64_t at = now_us;
+    if (script.bandwidth_bps)
+    {
+        uint64_t bits = (PBUF_IP_HLEN + icmp.size()) * 8;
+        at = (at > link_free_us? at: link_free_us) + bits * 1000000 / script.bandwidth_bps;
+        link_free_us = at;
+    }
+
+    if (script.down || !(hosts[dst & 0xff] & HOST_ICMP) || random01() < script.drop)
+        return;
+
+    event reply = { EVENT_REPLY, nullptr, nullptr, dst, std::vector<uint8_t>(PBUF_IP_HLEN) };
+    reply.data.insert(reply.data.end(), icmp.begin(), icmp.end());
+    reply.data[0] = 0x45;
+    reply.data[9] = IP_PROTO_ICMP;
+    reply.data[PBUF_IP_HLEN] = ICMP_ER;
+
+    at += 2 * script.delay_us;
+    if (script.jitter_us)
+        at += (uint64_t)(random01() * script.jitter_us);
+    if (random01() < script.reorder)
+        at += script.reorder_us;
+    if (random01() < script.duplicate)
+        events.emplace(at + 1, reply);
+    events.emplace(at, std::move(reply));
+}
+
+extern "C" err_t raw_sendto (struct raw_pcb* pcb, struct pbuf* p, const ip_addr_t* ipaddr)
+{
+    (void)pcb;
+    uint32_t dst = lwip_ntohl(ipaddr->addr);
+    if ((dst & 0xffffff00) != NET)
+        return ERR_RTE;
+    std::vector<uint8_t> icmp((uint8_t*)p->payload, (uint8_t*)p->payload + p->len);
+
+    int i = arp_find(dst);
+    if (i >= 0 && arp_table[i].state == ARP_STABLE)
+    {
+        transmit(dst, icmp);
+        return ERR_OK;
+    }
+    if (i < 0)
+    {
+        i = arp_new(dst);
+        if (!script.down && hosts[dst & 0xff])
+        {
+            event answer = { EVENT_ARP, nullptr, nullptr, dst, { } };
+            events.emplace(now_us + 2 * script.delay_us, std::move(answer));
+        }
+    }
+    // lwIP keeps the last packet only
+    arp_table[i].q = std::move(icmp);
+    return ERR_OK;
+}
+
+static void deliver (uint32_t src, const std::vector<uint8_t>& data)
+{
+    struct pbuf* p = pbuf_alloc(PBUF_RAW, data.size(), PBUF_RAM);
+    memcpy(p->payload, data.data(), data.size());
+    ip_addr_t addr = { lwip_htonl(src) };
+    // a pcb may be removed by a callback
+    std::vector<raw_pcb*> list = pcbs;
+    for (raw_pcb* pcb: list)
+    {
+        bool alive = false;
+        for (raw_pcb* q: pcbs)
+            alive |= q == pcb;
+        if (alive && pcb->recv && pcb->recv(pcb->arg, pcb, p, &addr))
+            return;
+    }
+    pbuf_free(p);
+}
+
+// stray echo reply (another sweep, spoofed, seq 0...)
+static void inject (uint32_t src, uint16_t id, uint16_t seq)
+{
+    std::vector<uint8_t> data(PBUF_IP_HLEN + sizeof(icmp_echo_hdr));
+    data[0] = 0x45;
+    data[9] = IP_PROTO_ICMP;
+    icmp_echo_hdr* h = (icmp_echo_hdr*)&data[PBUF_IP_HLEN];
+    h->type = ICMP_ER;
+    h->id = id;
+    h->seqno = lwip_htons(seq);
+    deliver(src, data);
+}
+
+/////////////////////
+// simulation loop
+
+static uint64_t arp_tick_us;
+
+static void run_until (uint64_t end_us)
+{
+    for (;;)
+    {
+        uint64_t next = events.empty()? end_us: events.begin()->first;
+        if (arp_tick_us <= next && arp_tick_us <= end_us)
+        {
+            // etharp_tmr()
+            now_us = arp_tick_us;
+            arp_tick_us += 1000000;
+            arp_expire();
+            continue;
+        }
+        if (events.empty() || next > end_us)
+            break;
+        auto i = events.begin();
+        event e = std::move(i->second);
+        now_us = i->first;
+        events.erase(i);
+
+        switch (e.type)
+        {
+        case EVENT_TIMER:
+            e.handler(e.arg);
+            break;
+        case EVENT_REPLY:
+            deliver(e.addr, e.data);
+            break;
+        case EVENT_ARP:
+        {
+            int a = arp_find(e.addr);
+            if (a >= 0 && arp_table[a].state == ARP_PENDING)
+            {
+                arp_table[a].state = ARP_STABLE;
+                arp_table[a].ctime_us = now_us;
+                if (!arp_table[a].q.empty())
+                    transmit(e.addr, arp_table[a].q);
+                arp_table[a].q.clear();
+            }
+            break;
+        }
+        }
+    }
+    now_us = end_us;
+}
+
+static void sim_reset ()
+{
+    events.clear();
+    for (raw_pcb* pcb: pcbs)
+        delete pcb;
+    pcbs.clear();
+    for (auto& e: arp_table)
+    {
+        e.state = ARP_EMPTY;
+        e.q.clear();
+    }
+    memset(hosts, 0, sizeof(hosts));
+    hosts[GATEWAY & 0xff] = HOST_ICMP;
+    now_us = 1000000;
+    // connected: the gateway is resolved
+    arp_table[0].state = ARP_STABLE;
+    arp_table[0].ip = GATEWAY;
+    arp_table[0].ctime_us = now_us;
+    arp_tick_us = now_us;
+    link_free_us = 0;
+    requests = arp_evicted = 0;
+    pbuf_failures = 0;
+    pbufs = 0;
+    sim_netif.ip_addr.addr = lwip_htonl(DEVICE);
+    sim_netif.netmask.addr = lwip_htonl(0xffffff00);
+    sim_netif.gw.addr = lwip_htonl(GATEWAY);
+    sim_netif.mtu = 1500;
+
+    ping_should_stop = 0;
+    ping_paused = 0;
+    ping_seq_num_send = ping_seq_num_recv = 0;
+    ping_rtt_ms = 0;
+}
+
+/////////////////////
+// hooks expected by ping.c
+
+struct trace_event* trace_ring;
+uint32_t trace_mask;
+uint32_t trace_head;
+
+static long faults;
+static uint64_t first_fault_us;
+static long rtts;
+
+extern "C" void pingFault ()
+{
+    if (!faults++)
+        first_fault_us = now_us;
+}
+
+extern "C" void ping_rtt_hook (uint32_t ms)
+{
+    (void)ms;
+    rtts++;
+}
+
+/////////////////////
+// scenarios
+
+static void alive (double hours)
+{
+    faults = rtts = 0;
+    ip_addr_t gw = { lwip_htonl(GATEWAY) };
+    ping_init(&gw);
+    run_until(now_us + (uint64_t)(hours * 3600e6));
+}
+
+static bool sweep_done;
+
+static void on_sweep (struct ping_sweep* s)
+{
+    (void)s;
+    sweep_done = true;
+}
+
+static struct ping_sweep sweep_state;
+
+static uint64_t sweep (uint16_t first = 1, uint16_t count = 254)
+{
+    hosts[1] = hosts[5] = hosts[77] = hosts[200] = hosts[254] = HOST_ICMP;
+    hosts[9] = HOST_ARP;
+    sweep_done = false;
+    ip_addr_t start = { lwip_htonl(NET | first) };
+    uint64_t t0 = now_us;
+    if (!ping_sweep_start(&sweep_state, &start, count, on_sweep))
+        return 0;
+    while (!sweep_done && now_us - t0 < 600000000ULL)
+        run_until(now_us + 100000);
+    return now_us - t0;
+}
+
+static bool train_done;
+
+static void on_train (struct ping_train* t)
+{
+    (void)t;
+    train_done = true;
+}
+
+static struct ping_train train_state;
+
+static bool train (uint16_t size, uint8_t count)
+{
+    train_done = false;
+    ip_addr_t gw = { lwip_htonl(GATEWAY) };
+    if (!ping_train_start(&train_state, &gw, size, count, on_train))
+        return false;
+    run_until(now_us + (PING_TRAIN_TIMEOUT + 100) * 1000ULL);
+    return train_done;
+}
+
+static void print_sweep (const struct ping_sweep* s, uint64_t us)
+{
+    printf("sweep: %u addresses in %.2fs (virtual), %u replies, %ld echo requests, %ld ARP entries recycled\n",
+        s->count, us / 1e6, s->replies, requests, arp_evicted);
+    for (int i = 0; i < s->count; i++)
+        if (ping_sweep_is_alive(s, i))
+            printf("  10.0.0.%d alive %ums\n", i + 1, s->rtt_ms[i]);
+        else if (ping_sweep_is_arp(s, i))
+            printf("  10.0.0.%d ARP only\n", i + 1);
+}
+
+static void print_train (const struct ping_train* t)
+{
+    printf("train: %u x %u bytes, %u/%u replies, %u bps (pairs: %u bps), rtt min %uus, dispersion %uus%s\n",
+        t->count, t->size, t->replies, t->sent, (unsigned)t->bandwidth_bps, (unsigned)t->pair_bps,
+        (unsigned)t->rtt_min_us, (unsigned)t->dispersion_us, t->fragmented? ", fragmented": "");
+}
+
+/////////////////////
+// checks
+
+static int failed;
+
+#define CHECK(cond, ...) \
+    do { if (!(cond)) { failed++; printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+static void stop_alive ()
+{
+    ping_should_stop = 1;
+    run_until(now_us + PING_DELAY * 1000ULL);
+}
+
+static void check_alive ()
+{
+    // clean link: one hour, no fault, every probe answered
+    sim_reset();
+    script = link_script { };
+    script.delay_us = 2000;
+    alive(1);
+    // last reply
+    run_until(now_us + 100000);
+    CHECK(!faults, "%ld faults", faults);
+    CHECK(ping_seq_num_send == 3600000 / PING_DELAY, "%u sent", ping_seq_num_send);
+    CHECK(ping_seq_num_recv == ping_seq_num_send, "%u/%u", ping_seq_num_recv, ping_seq_num_send);
+    CHECK(rtts == ping_seq_num_send && ping_rtt_ms == 4, "%ld rtts, last %ums", rtts, ping_rtt_ms);
+    stop_alive();
+    CHECK(!pbufs, "%ld pbufs leaked", pbufs);
+
+    // gateway gone: first fault after PING_MAX_FAILED_MN minutes
+    sim_reset();
+    script = link_script { };
+    script.down = true;
+    uint64_t t0 = now_us;
+    alive(0.5);
+    uint64_t expected = (PING_MAX_LOST + 2) * (uint64_t)PING_DELAY * 1000;
+    CHECK(faults && first_fault_us - t0 == expected, "first fault after %.1fs, expected %.1fs", (first_fault_us - t0) / 1e6, expected / 1e6);
+    stop_alive();
+
+    // shorter outage: no fault
+    sim_reset();
+    script = link_script { };
+    script.delay_us = 2000;
+    script.down = true;
+    alive((PING_MAX_FAILED_MN - 1) / 60.);
+    script.down = false;
+    run_until(now_us + 3600000000ULL);
+    CHECK(!faults, "%ld faults after a %d minutes outage", faults, PING_MAX_FAILED_MN - 1);
+    stop_alive();
+
+    // bad link: losses, duplicates, replies late past the next probe
+    sim_reset();
+    script = link_script { };
+    script.delay_us = 20000;
+    script.jitter_us = 100000;
+    script.drop = 0.3;
+    script.duplicate = 0.1;
+    script.reorder = 0.1;
+    script.reorder_us = PING_DELAY * 1500;
+    alive(24);
+    CHECK(!faults, "%ld faults on a lossy link", faults);
+    CHECK(rtts > ping_seq_num_send / 2, "%ld rtts for %u probes", rtts, ping_seq_num_send);
+    stop_alive();
+    CHECK(!pbufs, "%ld pbufs leaked", pbufs);
+
+    // paused: nothing sent, no fault
+    sim_reset();
+    script = link_script { };
+    script.down = true;
+    ping_paused = 1;
+    alive(1);
+    CHECK(!faults && !requests && !ping_seq_num_send, "paused: %ld faults, %ld sent", faults, requests);
+    stop_alive();
+}
+
+static void check_sweep ()
+{
+    // known hosts, stray replies, duplicates
+    sim_reset();
+    script = link_script { };
+    script.delay_us = 1000;
+    script.duplicate = 0.5;
+
+    hosts[1] = hosts[5] = hosts[77] = hosts[200] = hosts[254] = HOST_ICMP;
+    hosts[9] = HOST_ARP;
+    sweep_done = false;
+    ip_addr_t start = { lwip_htonl(NET | 1) };
+    uint64_t t0 = now_us;
+    CHECK(ping_sweep_start(&sweep_state, &start, 254, on_sweep), "start");
+    CHECK(!ping_sweep_start(&sweep_state, &start, 254, on_sweep), "started twice");
+    // seq 0 and a reply to a probe in flight from the wrong host
+    run_until(now_us + 2000);
+    inject(NET | 100, PING_SWEEP_ID, 0);
+    inject(NET | 100, PING_SWEEP_ID, (sweep_state.gen << 8) | (sweep_state.next - 1));
+    while (!sweep_done && now_us - t0 < 600000000ULL)
+        run_until(now_us + 10000);
+    uint64_t us = now_us - t0;
+
+    CHECK(sweep_done && !sweep_state.running, "not done after %.1fs", us / 1e6);
+    // a few seconds: silent addresses release their slot at PING_SWEEP_ARP_TIMEOUT
+    CHECK(us < 6000000, "%.1fs for a /24", us / 1e6);
+    static const int alive_hosts [] = { 1, 5, 77, 200, 254 };
+    int alive = 0, arp = 0;
+    for (int i = 0; i < 254; i++)
+    {
+        alive += ping_sweep_is_alive(&sweep_state, i);
+        arp += ping_sweep_is_arp(&sweep_state, i);
+    }
+    CHECK(alive == 5 && sweep_state.replies == 5, "%d alive, %u replies", alive, sweep_state.replies);
+    // the gateway was resolved, other hosts answer ARP first
+    for (int h: alive_hosts)
+        CHECK(   ping_sweep_is_alive(&sweep_state, h - 1)
+              && sweep_state.rtt_ms[h - 1] == (h == 1? 2: 4), "10.0.0.%d: %ums", h, sweep_state.rtt_ms[h - 1]);
+    CHECK(arp == 1 && ping_sweep_is_arp(&sweep_state, 9 - 1), "%d ARP only", arp);
+    CHECK(pcbs.empty(), "%zu pcbs left", pcbs.size());
+    run_until(now_us + 1000000);
+    CHECK(!pbufs, "%ld pbufs leaked", pbufs);
+
+    // allocation failures: the window keeps expiring and the sweep completes
+    sim_reset();
+    script = link_script { };
+    script.delay_us = 1000;
+    pbuf_failures = 50;
+    us = sweep();
+    CHECK(sweep_done && sweep_state.replies == 5 && us < 30000000, "%u replies in %.1fs with failures", sweep_state.replies, us / 1e6);
+}
+
+static void check_train ()
+{
+    // 2 Mbit/s bottleneck
+    sim_reset();
+    script = link_script { };
+    script.delay_us = 5000;
+    script.bandwidth_bps = 2000000;
+    CHECK(train(1000, 8), "train not done");
+    CHECK(train_state.replies == 8, "%u replies", train_state.replies);
+    CHECK(train_state.bandwidth_bps > 1960000 && train_state.bandwidth_bps < 2040000, "%u bps", (unsigned)train_state.bandwidth_bps);
+    CHECK(train_state.pair_bps > 1960000 && train_state.pair_bps < 2040000, "%u bps (pairs)", (unsigned)train_state.pair_bps);
+    CHECK(!train_state.fragmented, "fragmented");
+
+    // a lost reply: the estimate holds
+    script.drop = 0.2;
+    rng = 7;
+    CHECK(train(1000, 16), "lossy train not done");
+    CHECK(train_state.replies < 16 && train_state.replies >= 2, "%u replies", train_state.replies);
+    CHECK(train_state.bandwidth_bps > 1900000 && train_state.bandwidth_bps < 2100000, "%u bps", (unsigned)train_state.bandwidth_bps);
+
+    // matching replies from another host are not taken for the target's
+    script.drop = 0;
+    script.down = true;
+    train_done = false;
+    ip_addr_t gw = { lwip_htonl(GATEWAY) };
+    CHECK(ping_train_start(&train_state, &gw, 1000, 4, on_train), "start");
+    for (int i = 0; i < 4; i++)
+        inject(NET | 100, PING_TRAIN_ID, (train_state.gen << 8) | i);
+    run_until(now_us + (PING_TRAIN_TIMEOUT + 100) * 1000ULL);
+    CHECK(train_done && !train_state.replies, "%u replies from another host", train_state.replies);
+    script.down = false;
+
+    // above the mtu
+    train(2000, 4);
+    CHECK(train_state.fragmented, "not fragmented");
+    CHECK(pcbs.empty(), "%zu pcbs left", pcbs.size());
+    CHECK(!pbufs, "%ld pbufs leaked", pbufs);
+}
+
+/////////////////////
+// cpu per probe (simulator included)
+
+static double cpu_s ()
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench ()
+{
+    sim_reset();
+    script = link_script { };
+    script.delay_us = 2000;
+    double t = cpu_s();
+    alive(24 * 30);
+    t = cpu_s() - t;
+    printf("ping-alive: %ld probes (30 days) in %.3fs cpu: %.0f ns/probe\n", requests, t, t * 1e9 / requests);
+    stop_alive();
+
+    sim_reset();
+    script = link_script { };
+    script.delay_us = 1000;
+    long probes = 0;
+    t = cpu_s();
+    for (int i = 0; i < 200; i++)
+    {
+        sweep();
+        probes += sweep_state.next;
+    }
+    t = cpu_s() - t;
+    printf("sweep: %ld probes in %.3fs cpu: %.0f ns/probe\n", probes, t, t * 1e9 / probes);
+}
+
+int main (int argc, char* argv[])
+{
+    link_script options { };
+    int opt;
+    while ((opt = getopt(argc, argv, "d:u:r:l:j:w:s:")) != -1)
+        switch (opt)
+        {
+        case 'd': options.drop = atof(optarg); break;
+        case 'u': options.duplicate = atof(optarg); break;
+        case 'r': options.reorder = atof(optarg); break;
+        case 'l': options.delay_us = atof(optarg) * 1000; break;
+        case 'j': options.jitter_us = atof(optarg) * 1000; break;
+        case 'w': options.bandwidth_bps = atof(optarg) * 1000; break;
+        case 's': rng = strtoull(optarg, nullptr, 0)?: 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-d drop] [-u dup] [-r reorder] [-l delay_ms] [-j jitter_ms] [-w kbps] [-s seed] [test | bench | alive hours | sweep | train size count]\n", argv[0]);
+            return 1;
+        }
+    options.reorder_us = 1500 * PING_DELAY;
+    const char* mode = optind < argc? argv[optind]: "test";
+
+    if (!strcmp(mode, "test"))
+    {
+        check_alive();
+        check_sweep();
+        check_train();
+        printf("%s\n", failed? "FAILED": "ok");
+        return failed? 1: 0;
+    }
+
+    if (!strcmp(mode, "bench"))
+    {
+        bench();
+        return 0;
+    }
+
+    sim_reset();
+    script = options;
+    if (!strcmp(mode, "alive") && optind + 1 < argc)
+    {
+        alive(atof(argv[optind + 1]));
+        printf("ping-alive: %u sent, %ld answered, last rtt %ums, %ld faults", ping_seq_num_send, rtts, ping_rtt_ms, faults);
+        if (faults)
+            printf(", first after %.1fs", (first_fault_us - 1000000) / 1e6);
+        printf("\n");
+    }
+    else if (!strcmp(mode, "sweep"))
+    {
+        uint64_t us = sweep();
+        print_sweep(&sweep_state, us);
+    }
+    else if (!strcmp(mode, "train") && optind + 2 < argc)
+    {
+        train(atoi(argv[optind + 1]), atoi(argv[optind + 2]));
+        print_train(&train_state);
+    }
+    else
+    {
+        fprintf(stderr, "%s: unknown mode\n", mode);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,798 @@
+/*
+ tcpdump-host: the tcpdump server core (src/utility/tcpdump.cpp) on a host
+
+ posix sockets replace WiFiServer/WiFiClient and WiFiUDP, and a synthetic
+ traffic generator replaces phy_capture: ethernet frames of tcp and udp
+ flows (and some arp) are given to tcpdump_capture() while a client is
+ connected, on a virtual clock (timestamps and flow ageing do not depend on
+ the host's speed).
+
+ build (from the repository root, char is unsigned on the esp):
+     g++ -O2 -Wall -Wextra -funsigned-char -Itools/netdump-decode -Isrc \
+         tools/tcpdump-host/tcpdump-host.cpp src/utility/tcpdump.cpp \
+         -o tcpdump-host
+ usage:
+     tcpdump-host [test]                     checks, exit status 1 on failure
+     tcpdump-host [options] bench            packets/s through tcpdump_capture() to a local client
+     tcpdump-host [options] serve            then: nc localhost 2 | tcpdump -r -
+     tcpdump-host [options] udp host         datagrams, for: tools/netdump-udp-rx | tcpdump -r -
+     options:
+         -p port (default 2, or TCPDUMP_UDP_PORT)  -s snaplen (96)  -m buffer bytes (TCPDUMP_BUFFER_MAX)
+         -f flows (8)  -r packets/s (1000)  -n packets (0: forever)  -b packets[:bytes] flow budget
+
+ released to the public domain
+*/
+
+#include <NetDump.h>
+#include <utility/tcpdump.h>
+#include <utility/trace.h>
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/sockios.h>
+
+// trace.h ring, disabled
+struct trace_event* trace_ring;
+uint32_t trace_mask;
+uint32_t trace_head;
+
+/////////////////////
+// posix backend
+
+struct host
+{
+    int listen_fd = -1;
+    int client_fd = -1;
+    int udp_fd = -1;
+    struct sockaddr_in collector;
+    std::vector<char> buf;
+    size_t bufsize = TCPDUMP_BUFFER_MAX;
+    bool capturing = false;
+    uint64_t clock_us = 1000000;        // virtual
+};
+
+static host h;
+
+static bool host_accept (void*)
+{
+    int fd = accept(h.listen_fd, nullptr, nullptr);
+    if (fd < 0)
+        return false;
+    if (h.client_fd >= 0)
+        close(h.client_fd);
+    h.client_fd = fd;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    // the buffer is allocated when a client connects, like on the esp
+    h.buf.assign(h.bufsize, 0);
+    tcpdump_buffer(h.buf.data(), h.buf.size());
+    return true;
+}
+
+static bool host_connected (void*)
+{
+    if (h.client_fd < 0)
+        return false;
+    char c;
+    ssize_t n = recv(h.client_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+    {
+        close(h.client_fd);
+        h.client_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+// room in the socket send buffer: send() below never waits for more
+static size_t host_writable (void*)
+{
+    if (h.client_fd < 0)
+        return 0;
+    int sndbuf = 0, queued = 0;
+    socklen_t len = sizeof(sndbuf);
+    if (   getsockopt(h.client_fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, &len) != 0
+        || ioctl(h.client_fd, SIOCOUTQ, &queued) != 0)
+        return 0;
+    // linux doubles SO_SNDBUF for its own bookkeeping
+    return sndbuf / 2 > queued? sndbuf / 2 - queued: 0;
+}
+
+static bool host_send (void*, const char* data, size_t len)
+{
+    if (h.udp_fd >= 0)
+        return sendto(h.udp_fd, data, len, MSG_DONTWAIT, (struct sockaddr*)&h.collector, sizeof(h.collector)) == (ssize_t)len;
+    while (len)
+    {
+        ssize_t n = send(h.client_fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+static void host_now (void*, uint32_t* sec, uint32_t* usec)
+{
+    *sec = h.clock_us / 1000000;
+    *usec = h.clock_us % 1000000;
+}
+
+static uint32_t host_now_ms (void*)
+{
+    return h.clock_us / 1000;
+}
+
+static void host_capture (void*, bool on)
+{
+    h.capturing = on;
+}
+
+static const tcpdump_ops host_ops =
+{
+    host_accept,
+    host_connected,
+    host_writable,
+    host_send,
+    host_now,
+    host_now_ms,
+    host_capture,
+    nullptr,
+};
+
+static int listen_on (uint16_t port, bool any)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in sin = { };
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    sin.sin_addr.s_addr = htonl(any? INADDR_ANY: INADDR_LOOPBACK);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&sin, sizeof(sin)) != 0 || listen(fd, 1) != 0)
+    {
+        perror("listen");
+        exit(1);
+    }
+    return fd;
+}
+
+static uint16_t local_port (int fd)
+{
+    struct sockaddr_in sin;
+    socklen_t len = sizeof(sin);
+    getsockname(fd, (struct sockaddr*)&sin, &len);
+    return ntohs(sin.sin_port);
+}
+
+// tcpdump_setup()
+static void setup_stream (uint16_t port, size_t snap, bool any)
+{
+    h.listen_fd = listen_on(port, any);
+    tcpdump_begin(&host_ops, nullptr, nullptr, 0, snap, local_port(h.listen_fd), 0);
+}
+
+// tcpdump_udp_setup()
+static void setup_udp (const char* to, uint16_t port, size_t snap)
+{
+    h.udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    h.collector = { };
+    h.collector.sin_family = AF_INET;
+    h.collector.sin_port = htons(port);
+    if (h.udp_fd < 0 || inet_pton(AF_INET, to, &h.collector.sin_addr) != 1)
+    {
+        fprintf(stderr, "%s: bad collector\n", to);
+        exit(1);
+    }
+    // one datagram at most, like DGRAMSIZE on the esp
+    h.buf.assign(h.bufsize < 1460? h.bufsize: 1460, 0);
+    tcpdump_begin(&host_ops, nullptr, h.buf.data(), h.buf.size(), snap, port, h.collector.sin_addr.s_addr);
+}
+
+static void teardown ()
+{
+    for (int* fd: { &h.listen_fd, &h.client_fd, &h.udp_fd })
+        if (*fd >= 0)
+        {
+            close(*fd);
+            *fd = -1;
+        }
+    tcpdump_buffer(nullptr, 0);
+    h.capturing = false;
+}
+
+/////////////////////
+// traffic generator
+
+struct gen_flow
+{
+    uint32_t a, b;                      // network order, a is the esp
+    uint16_t pa, pb;
+    uint8_t proto;
+    uint32_t seq;
+};
+
+static uint64_t rng = 88172645463325252ULL;
+
+static uint32_t rnd ()
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+static void put16 (char* p, uint16_t v) { p[0] = v >> 8; p[1] = v; }
+static void put32 (char* p, uint32_t v) { put16(p, v >> 16); put16(p + 2, v); }
+
+static uint16_t ip_sum (const char* hdr, size_t len)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < len; i += 2)
+        sum += ntoh16(hdr + i);
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return ~sum;
+}
+
+static const char esp_mac[6] = { 0x5c, 0xcf, 0x7f, 0x00, 0x00, 0x01 };
+static const char gw_mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0xfe };
+
+// ethernet + ipv4 + tcp/udp, usr bytes of payload, returns the frame length
+static size_t make_frame (char* frame, gen_flow* f, bool out, size_t usr, uint8_t tcp_flags = 0x18)
+{
+    memcpy(frame, out? gw_mac: esp_mac, 6);
+    memcpy(frame + 6, out? esp_mac: gw_mac, 6);
+    put16(frame + 12, 0x0800);
+
+    char* ip = frame + ETH_HDR_LEN;
+    size_t l4 = f->proto == 6? 20: 8;
+    memset(ip, 0, 20);
+    ip[0] = 0x45;
+    put16(ip + 2, 20 + l4 + usr);
+    put16(ip + 4, rnd());
+    put16(ip + 6, 0x4000);
+    ip[8] = 64;
+    ip[9] = f->proto;
+    memcpy(ip + 12, out? &f->a: &f->b, 4);
+    memcpy(ip + 16, out? &f->b: &f->a, 4);
+    put16(ip + 10, ip_sum(ip, 20));
+
+    char* th = ip + 20;
+    put16(th, out? f->pa: f->pb);
+    put16(th + 2, out? f->pb: f->pa);
+    if (f->proto == 6)
+    {
+        put32(th + 4, f->seq);
+        put32(th + 8, 0);
+        put16(th + 12, (5 << 12) | tcp_flags);
+        put16(th + 14, 5840);
+        put32(th + 16, 0);
+        f->seq += usr;
+    }
+    else
+    {
+        put16(th + 4, 8 + usr);
+        put16(th + 6, 0);
+    }
+    for (size_t i = 0; i < usr; i++)
+        th[l4 + i] = 'a' + i % 26;
+    return ETH_HDR_LEN + 20 + l4 + usr;
+}
+
+static size_t make_arp (char* frame)
+{
+    memset(frame, 0xff, 6);
+    memcpy(frame + 6, gw_mac, 6);
+    put16(frame + 12, 0x0806);
+    char* arp = frame + ETH_HDR_LEN;
+    put16(arp, 1);
+    put16(arp + 2, 0x0800);
+    arp[4] = 6;
+    arp[5] = 4;
+    put16(arp + 6, 1);
+    memcpy(arp + 8, gw_mac, 6);
+    put32(arp + 14, 0x0a0000fe);
+    memset(arp + 18, 0, 6);
+    put32(arp + 24, 0x0a000001 + rnd() % 253);
+    return ETH_HDR_LEN + 28;
+}
+
+static std::vector<gen_flow> make_flows (int count)
+{
+    std::vector<gen_flow> flows(count);
+    for (int i = 0; i < count; i++)
+    {
+        gen_flow& f = flows[i];
+        f.a = htonl(0x0a00000a);
+        f.b = htonl(0x5db8d822 + i);
+        f.pa = 49152 + i;
+        f.pb = i % 3? 443: 53;
+        f.proto = i % 3? 6: 17;
+        f.seq = rnd();
+    }
+    return flows;
+}
+
+// one packet of a random flow (1 in 16: arp), as phy_capture would
+static size_t generate (char* frame, std::vector<gen_flow>& flows)
+{
+    if (rnd() % 16 == 0)
+        return make_arp(frame);
+    gen_flow& f = flows[rnd() % flows.size()];
+    size_t usr = f.proto == 6? rnd() % 1461: rnd() % 512;
+    return make_frame(frame, &f, rnd() % 2, usr);
+}
+
+/////////////////////
+// client side
+
+// drains a tcp client socket, parses the pcap stream
+struct reader
+{
+    int fd;
+    std::string data;
+
+    bool poll ()
+    {
+        char chunk[16384];
+        ssize_t n;
+        bool got = false;
+        while ((n = recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT)) > 0)
+        {
+            data.append(chunk, n);
+            got = true;
+        }
+        return got;
+    }
+};
+
+static int connect_to (uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in sin = { };
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&sin, sizeof(sin)) != 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+    return fd;
+}
+
+// tcpdump_loop() and the client, until everything buffered is received
+static void flush (reader* r)
+{
+    for (int idle = 0; idle < 100; )
+    {
+        tcpdump_poll();
+        if (r->poll())
+            idle = 0;
+        else if (!tcpdump_buffered())
+            idle++;
+    }
+}
+
+/////////////////////
+// checks
+
+static int failed;
+
+#define CHECK(cond, ...) \
+    do { if (!(cond)) { failed++; printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+static void reset_counters ()
+{
+    tcpdump_err = tcpdump_flow_skipped = tcpdump_captured = tcpdump_buffer_peak = 0;
+    tcpdump_flow_budget(0, 0);
+}
+
+// a stream session with a connected client
+static void stream_session (reader* r, size_t snap, size_t bufsize)
+{
+    reset_counters();
+    h.bufsize = bufsize;
+    setup_stream(0, snap, false);
+    r->fd = connect_to(local_port(h.listen_fd));
+    while (!h.capturing)
+        tcpdump_poll();
+}
+
+static void end_session (reader* r)
+{
+    close(r->fd);
+    teardown();
+}
+
+// feed one frame, flushing as tcpdump_loop() would
+static void feed (reader* r, const char* frame, size_t len, uint32_t interval_us = 100)
+{
+    h.clock_us += interval_us;
+    if (h.capturing)
+        tcpdump_capture(0, frame, len, 0, 1);
+    tcpdump_poll();
+    r->poll();
+}
+
+static void check_stream ()
+{
+    // every record, in order, as generated
+    const size_t snap = 96, count = 5000;
+    reader r;
+    stream_session(&r, snap, 64 * 1024);
+
+    std::vector<std::string> sent;
+    std::vector<gen_flow> flows = make_flows(8);
+    char frame[1536];
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t len = generate(frame, flows);
+        sent.push_back(std::string(frame, len));
+        feed(&r, frame, len);
+    }
+    flush(&r);
+
+    const std::string& d = r.data;
+    uint32_t magic = 0, snaplen = 0, linktype = 0;
+    if (d.size() >= 24)
+    {
+        memcpy(&magic, &d[0], 4);
+        memcpy(&snaplen, &d[16], 4);
+        memcpy(&linktype, &d[20], 4);
+    }
+    CHECK(magic == 0xa1b2c3d4 && snaplen == snap && linktype == 1, "preamble %08x snaplen %u linktype %u", magic, snaplen, linktype);
+    CHECK(!tcpdump_err && tcpdump_captured == count, "%zu captured, %zu lost", tcpdump_captured, tcpdump_err);
+
+    size_t pos = 24, n = 0, bad = 0;
+    uint64_t prev_us = 0;
+    while (pos + 16 <= d.size() && n < sent.size())
+    {
+        uint32_t hdr[4];
+        memcpy(hdr, &d[pos], 16);
+        const std::string& s = sent[n];
+        size_t caplen = (s.size() + 3) & ~3;
+        if (caplen > snap)
+            caplen = snap;
+        uint64_t us = hdr[0] * 1000000ULL + hdr[1];
+        if (   hdr[2] != caplen
+            || hdr[3] != (s.size() < caplen? caplen: s.size())
+            || us <= prev_us
+            || pos + 16 + caplen > d.size()
+            || memcmp(&d[pos + 16], s.data(), s.size() < caplen? s.size(): caplen))
+            bad++;
+        prev_us = us;
+        pos += 16 + hdr[2];
+        n++;
+    }
+    CHECK(n == count && !bad && pos == d.size(), "%zu records, %zu bad, %zu trailing bytes", n, bad, d.size() - pos);
+    end_session(&r);
+}
+
+static void check_drops ()
+{
+    // the client does not read: the buffer fills, the rest is accounted
+    reader r;
+    stream_session(&r, 96, 4096);
+    std::vector<gen_flow> flows = make_flows(4);
+    char frame[1536];
+    const size_t count = 2000;
+    for (size_t i = 0; i < count; i++)
+    {
+        h.clock_us += 100;
+        tcpdump_capture(0, frame, generate(frame, flows), 0, 1);
+    }
+    CHECK(tcpdump_err && tcpdump_captured + tcpdump_err == count && tcpdump_buffer_peak <= 4096,
+        "%zu captured + %zu lost / %zu, peak %zu", tcpdump_captured, tcpdump_err, count, tcpdump_buffer_peak);
+    end_session(&r);
+}
+
+// packets of each flow in the output stream
+static std::unordered_map<uint64_t, int> per_flow (const std::string& d)
+{
+    std::unordered_map<uint64_t, int> count;
+    for (size_t pos = 24; pos + 16 <= d.size(); )
+    {
+        uint32_t caplen;
+        memcpy(&caplen, &d[pos + 8], 4);
+        const char* f = &d[pos + 16];
+        if (netDump_is_IPv4(f))
+        {
+            uint16_t pa = netDump_getSrcPort(f), pb = netDump_getDstPort(f);
+            count[(uint64_t)(pa < pb? pa: pb) << 16 | (pa < pb? pb: pa)]++;
+        }
+        pos += 16 + caplen;
+    }
+    return count;
+}
+
+static void check_budget ()
+{
+    std::vector<gen_flow> flows = make_flows(8);
+    char frame[1536];
+
+    // packet budget: 3 per flow, both directions counted together, FIN always
+    {
+        reader r;
+        stream_session(&r, 96, 64 * 1024);
+        tcpdump_flow_budget(3);
+        for (int round = 0; round < 10; round++)
+            for (gen_flow& f: flows)
+                feed(&r, frame, make_frame(frame, &f, round % 2, 100));
+        feed(&r, frame, make_frame(frame, &flows[1], true, 0, 0x11));
+        flush(&r);
+        auto count = per_flow(r.data);
+        bool ok = count.size() == flows.size();
+        for (auto& c: count)
+            ok = ok && c.second == (c.first == ((uint64_t)flows[1].pb << 16 | flows[1].pa)? 4: 3);
+        CHECK(ok && tcpdump_flow_skipped == 7 * flows.size(), "%zu flows, %zu skipped", count.size(), tcpdump_flow_skipped);
+        end_session(&r);
+    }
+
+    // byte budget alone (packets = 0)
+    {
+        reader r;
+        stream_session(&r, 96, 64 * 1024);
+        tcpdump_flow_budget(0, 1000);
+        for (int round = 0; round < 10; round++)
+            for (gen_flow& f: flows)
+                feed(&r, frame, make_frame(frame, &f, true, 300 - 20 - 14 - (f.proto == 6? 20: 8)));
+        flush(&r);
+        // 300 bytes frames: 4 fit before reaching 1000
+        auto count = per_flow(r.data);
+        bool ok = count.size() == flows.size();
+        for (auto& c: count)
+            ok = ok && c.second == 4;
+        CHECK(ok && tcpdump_flow_skipped == 6 * flows.size(), "%zu flows, %zu skipped", count.size(), tcpdump_flow_skipped);
+        end_session(&r);
+    }
+
+    // idle flows are forgotten: a new budget
+    {
+        reader r;
+        stream_session(&r, 96, 64 * 1024);
+        tcpdump_flow_budget(2);
+        for (int i = 0; i < 3; i++)
+            feed(&r, frame, make_frame(frame, &flows[0], true, 10));
+        feed(&r, frame, make_frame(frame, &flows[0], true, 10), TCPDUMP_FLOW_IDLE * 1000);
+        flush(&r);
+        CHECK(tcpdump_captured == 3 && tcpdump_flow_skipped == 1, "%zu captured, %zu skipped", tcpdump_captured, tcpdump_flow_skipped);
+        end_session(&r);
+    }
+}
+
+// flow_hash() in tcpdump.cpp
+static uint32_t flow_hash (uint32_t a, uint32_t b, uint16_t pa, uint16_t pb, uint8_t proto)
+{
+    uint32_t hash = 2166136261u;
+    hash = (hash ^ a) * 16777619u;
+    hash = (hash ^ b) * 16777619u;
+    hash = (hash ^ ((pa << 16) | pb)) * 16777619u;
+    hash = (hash ^ proto) * 16777619u;
+    hash ^= hash >> 16;
+    return hash?: 1;
+}
+
+static void check_collision ()
+{
+    // two flows with the same hash keep separate budgets
+    // (random peers and ports until two hashes meet)
+    gen_flow x = make_flows(1)[0], y = x;
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint16_t>> seen; // hash -> peer, port
+    bool found = false;
+    for (int i = 0; i < 1 << 22 && !found; i++)
+    {
+        uint32_t nb = htonl(0x0b000000 | (rnd() & 0xffffff));
+        uint16_t np = rnd();
+        bool lo = x.a < nb;
+        uint32_t hash = flow_hash(lo? x.a: nb, lo? nb: x.a, lo? x.pa: np, lo? np: x.pa, x.proto);
+        auto it = seen.find(hash);
+        if (it != seen.end() && it->second != std::make_pair(nb, np))
+        {
+            x.b = it->second.first;
+            x.pb = it->second.second;
+            y.b = nb;
+            y.pb = np;
+            found = true;
+        }
+        seen[hash] = { nb, np };
+    }
+    CHECK(found, "no collision found");
+    if (!found)
+        return;
+
+    reader r;
+    stream_session(&r, 96, 64 * 1024);
+    tcpdump_flow_budget(1);
+    char frame[1536];
+    feed(&r, frame, make_frame(frame, &x, true, 10));
+    feed(&r, frame, make_frame(frame, &y, true, 10));
+    feed(&r, frame, make_frame(frame, &x, true, 10));
+    flush(&r);
+    CHECK(tcpdump_captured == 2 && tcpdump_flow_skipped == 1, "%zu captured, %zu skipped", tcpdump_captured, tcpdump_flow_skipped);
+    end_session(&r);
+}
+
+static void check_udp ()
+{
+    // datagrams: header, sequence, every record accounted
+    int rx = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in sin = { };
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int big = 1 << 22;
+    setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &big, sizeof(big));
+    bind(rx, (struct sockaddr*)&sin, sizeof(sin));
+
+    reset_counters();
+    h.bufsize = 1460;
+    setup_udp("127.0.0.1", local_port(rx), 96);
+    std::vector<gen_flow> flows = make_flows(4);
+    char frame[1536];
+    const size_t count = 1000;
+    size_t datagrams = 0, records = 0, bad = 0;
+    uint32_t expect = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        h.clock_us += 100;
+        tcpdump_capture(0, frame, generate(frame, flows), 0, 1);
+        if (i % 7 == 6 || i == count - 1)
+            tcpdump_poll();
+        char dgram[2048];
+        ssize_t n;
+        while ((n = recv(rx, dgram, sizeof(dgram), MSG_DONTWAIT)) > 0)
+        {
+            uint32_t seq;
+            uint16_t snaplen, cnt;
+            memcpy(&seq, dgram + 4, 4);
+            memcpy(&snaplen, dgram + 8, 2);
+            memcpy(&cnt, dgram + 10, 2);
+            size_t pos = TCPDUMP_DGRAM_HDR, recs = 0;
+            while (pos + 16 <= (size_t)n)
+            {
+                uint32_t caplen;
+                memcpy(&caplen, dgram + pos + 8, 4);
+                pos += 16 + caplen;
+                recs++;
+            }
+            if (memcmp(dgram, "NDU1", 4) || seq != expect || snaplen != 96 || cnt != recs || pos != (size_t)n)
+                bad++;
+            expect = seq + 1;
+            records += recs;
+            datagrams++;
+        }
+    }
+    CHECK(!bad && records == count && records == tcpdump_captured && !tcpdump_err,
+        "%zu datagrams (%zu bad), %zu records, %zu captured, %zu lost", datagrams, bad, records, tcpdump_captured, tcpdump_err);
+    teardown();
+    close(rx);
+}
+
+/////////////////////
+// bench and serve
+
+static void bench (size_t snap, size_t bufsize, int nflows, size_t count, uint16_t budget_packets, uint32_t budget_bytes)
+{
+    reader r;
+    stream_session(&r, snap, bufsize);
+    tcpdump_flow_budget(budget_packets, budget_bytes);
+    std::vector<gen_flow> flows = make_flows(nflows);
+
+    // frames generated beforehand, only capture and output are timed
+    std::vector<std::string> frames;
+    char frame[1536];
+    for (size_t i = 0; i < 4096; i++)
+        frames.push_back(std::string(frame, generate(frame, flows)));
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+        const std::string& f = frames[i % frames.size()];
+        h.clock_us += 10;
+        tcpdump_capture(0, f.data(), f.size(), 0, 1);
+        if (i % 8 == 7)
+        {
+            tcpdump_poll();
+            r.poll();
+        }
+    }
+    flush(&r);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("%zu packets in %.3fs: %.0f packets/s, %.0f ns/packet, %zu captured, %zu lost, %zu flow-skipped, buffer peak %zu/%zu, %zu bytes out\n",
+        count, s, count / s, s * 1e9 / count, tcpdump_captured, tcpdump_err, tcpdump_flow_skipped,
+        tcpdump_buffer_peak, bufsize, r.data.size());
+    end_session(&r);
+}
+
+// real time, paced generator
+static void serve (size_t rate, size_t count, int nflows)
+{
+    std::vector<gen_flow> flows = make_flows(nflows);
+    char frame[1536];
+    auto start = std::chrono::steady_clock::now();
+    size_t sent = 0;
+    while (!count || sent < count)
+    {
+        uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        h.clock_us = 1000000 + us;
+        for (; h.capturing && sent < us * rate / 1000000 && (!count || sent < count); sent++)
+            tcpdump_capture(0, frame, generate(frame, flows), 0, 1);
+        if (!h.capturing)
+            start = std::chrono::steady_clock::now() - std::chrono::microseconds(sent * 1000000 / rate);
+        tcpdump_poll();
+        usleep(1000);
+    }
+    tcpdump_poll();
+    fprintf(stderr, "%zu captured, %zu lost, %zu flow-skipped\n", tcpdump_captured, tcpdump_err, tcpdump_flow_skipped);
+}
+
+int main (int argc, char* argv[])
+{
+    int port = -1, nflows = 8;
+    size_t snap = 96, rate = 1000, count = 0;
+    unsigned budget_packets = 0, budget_bytes = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:s:m:f:r:n:b:")) != -1)
+        switch (opt)
+        {
+        case 'p': port = atoi(optarg); break;
+        case 's': snap = atoi(optarg); break;
+        case 'm': h.bufsize = atoi(optarg) & ~3; break;
+        case 'f': nflows = atoi(optarg) > 0? atoi(optarg): 1; break;
+        case 'r': rate = atoi(optarg) > 0? atoi(optarg): 1; break;
+        case 'n': count = atol(optarg); break;
+        case 'b': sscanf(optarg, "%u:%u", &budget_packets, &budget_bytes); break;
+        default:
+            fprintf(stderr, "usage: %s [test] | [options] bench | [options] serve | [options] udp host\n", argv[0]);
+            return 1;
+        }
+    const char* mode = optind < argc? argv[optind]: "test";
+
+    if (!strcmp(mode, "test"))
+    {
+        check_stream();
+        check_drops();
+        check_budget();
+        check_collision();
+        check_udp();
+        printf("tcpdump-host: %s\n", failed? "FAILED": "ok");
+        return failed? 1: 0;
+    }
+
+    if (!strcmp(mode, "bench"))
+    {
+        bench(snap, h.bufsize, nflows, count? count: 2000000, budget_packets, budget_bytes);
+    }
+    else if (!strcmp(mode, "serve"))
+    {
+        setup_stream(port < 0? 2: port, snap, true);
+        tcpdump_flow_budget(budget_packets, budget_bytes);
+        serve(rate, count, nflows);
+    }
+    else if (!strcmp(mode, "udp") && optind + 1 < argc)
+    {
+        setup_udp(argv[optind + 1], port < 0? TCPDUMP_UDP_PORT: port, snap);
+        tcpdump_flow_budget(budget_packets, budget_bytes);
+        serve(rate, count, nflows);
+    }
+    else
+    {
+        fprintf(stderr, "%s: unknown mode\n", mode);
+        return 1;
+    }
+    return 0;
+}
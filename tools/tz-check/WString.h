@@ -0,0 +1,18 @@
+// host stand-in for the flash string helpers used by configTZ.cpp, see tz-check.cpp
+
+#ifndef __WSTRING_H
+#define __WSTRING_H
+
+#include <stdint.h>
+#include <string.h>
+
+class __FlashStringHelper;
+
+#define PROGMEM
+#define PGM_P                   const char*
+#define FPSTR(p)                (reinterpret_cast<const __FlashStringHelper*>(p))
+#define pgm_read_byte(p)        (*(const uint8_t*)(p))
+#define pgm_read_word(p)        (*(const uint16_t*)(p))
+#define strncpy_P               strncpy
+
+#endif // __WSTRING_H
@@ -0,0 +1,311 @@
+/*
+ tz-check: the library's time zone code (configTZ.cpp) against glibc, on a host
+
+ every TZ.h zone present in the system zoneinfo is looked up with
+ configTZByName() and converted with TZToLocal(), then compared
+ - with glibc evaluating the same POSIX rule: a difference is a bug in
+   configTZ.cpp (parser, transition dates, cache)
+ - with glibc's zoneinfo file: a difference is a TZ.h rule out of date
+   (run TZupdate)
+ at every step and at each transition found in between (to the second).
+ exits with 1 on any difference, and with -b when TZToLocal() is not
+ faster than glibc's localtime_r()
+
+ build (from the repository root):
+     g++ -O2 -Itools/tz-check -Isrc src/utility/configTZ.cpp tools/tz-check/tz-check.cpp -o tz-check
+ usage:
+     tz-check [-y first:last] [-s step] [-z zoneinfo] [-p] [-b] [-v]
+     -y: years, default: this year and the next four
+     -s: seconds between samples, default 3600
+     -p: parser only, no comparison with zoneinfo
+     -b: benchmark configTZ(), TZToLocal() and localtime_r() per zone
+     -v: one line per zone
+
+ released to the public domain
+*/
+
+#include <WString.h>
+#include <EspGoodies.h>
+#include <utility/TZdb.h>
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static const char* zoneinfo = "/usr/share/zoneinfo";
+static std::vector<std::string> zones;
+static bool verbose;
+
+// "America/Port-au-Prince" -> "America_PortmaumPrince" (TZ.h names, see TZupdate)
+static std::string tzh_name (const std::string& name)
+{
+    std::string s = name;
+    for (char& c: s)
+        c = c == '/'? '_': c == '-'? 'm': c == '+'? 'p': c;
+    return s;
+}
+
+static int walk (const char* path, const struct stat* st, int type, struct FTW* ftw)
+{
+    (void)st;
+    (void)ftw;
+    const char* name = path + strlen(zoneinfo) + 1;
+    if (type == FTW_F && *name >= 'A' && *name <= 'Z' && !strchr(name, '.'))
+        zones.push_back(name);
+    return 0;
+}
+
+static void use_tz (const char* tz)
+{
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+static long glibc_offset (time_t t)
+{
+    struct tm tm;
+    localtime_r(&t, &tm);
+    return tm.tm_gmtoff;
+}
+
+static long lib_offset (time_t t)
+{
+    return TZToLocal(t) - t;
+}
+
+static std::string utc (time_t t)
+{
+    char s[32];
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(s, sizeof(s), "%Y-%m-%d %H:%M:%S UTC", &tm);
+    return s;
+}
+
+// glibc (current TZ) at each sample and at each transition in between,
+// against TZToLocal(), first difference in *at
+static bool compare (const std::vector<time_t>& samples, time_t* at, long* lib, long* ref)
+{
+    long prev = 0;
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        time_t t = samples[i];
+        long off = glibc_offset(t);
+        if (i && off != prev)
+        {
+            // transition in (samples[i - 1], t]: first second of the new offset
+            time_t lo = samples[i - 1], hi = t;
+            while (hi - lo > 1)
+            {
+                time_t mid = lo + (hi - lo) / 2;
+                if (glibc_offset(mid) == prev)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            for (time_t s: { hi - 1, hi })
+            {
+                long r = glibc_offset(s);
+                if (lib_offset(s) != r)
+                {
+                    *at = s;
+                    *lib = lib_offset(s);
+                    *ref = r;
+                    return false;
+                }
+            }
+        }
+        if (lib_offset(t) != off)
+        {
+            *at = t;
+            *lib = lib_offset(t);
+            *ref = off;
+            return false;
+        }
+        prev = off;
+    }
+    return true;
+}
+
+static double ns_since (std::chrono::steady_clock::time_point t0, size_t n)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+}
+
+struct bench_result
+{
+    double config_ns;
+    double seq_ns;      // TZToLocal(), consecutive minutes
+    double rnd_ns;      // TZToLocal(), random instants
+    double glibc_ns;    // localtime_r(), same instants
+};
+
+static volatile time_t sink;
+
+static bench_result bench (const char* name, const char* rule, const std::vector<time_t>& random)
+{
+    bench_result r;
+    const int configs = 200;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < configs; i++)
+        configTZByName(name);
+    r.config_ns = ns_since(t0, configs);
+
+    time_t start = random[0] - random[0] % 86400;
+    const size_t minutes = 366 * 24 * 60;
+    time_t sum = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < minutes; i++)
+        sum += TZToLocal(start + (time_t)i * 60);
+    r.seq_ns = ns_since(t0, minutes);
+
+    t0 = std::chrono::steady_clock::now();
+    for (time_t t: random)
+        sum += TZToLocal(t);
+    r.rnd_ns = ns_since(t0, random.size());
+
+    use_tz(rule);
+    t0 = std::chrono::steady_clock::now();
+    for (time_t t: random)
+    {
+        struct tm tm;
+        localtime_r(&t, &tm);
+        sum += tm.tm_gmtoff;
+    }
+    r.glibc_ns = ns_since(t0, random.size());
+    sink = sum;
+    return r;
+}
+
+int main (int argc, char* argv[])
+{
+    time_t now = time(nullptr);
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    int first = tm.tm_year + 1900, last = first + 4;
+    time_t step = 3600;
+    bool parser_only = false, benchmark = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "y:s:z:pbv")) != -1)
+        switch (opt)
+        {
+        case 'y': if (sscanf(optarg, "%d:%d", &first, &last) != 2) last = first; break;
+        case 's': step = atol(optarg); break;
+        case 'z': zoneinfo = optarg; break;
+        case 'p': parser_only = true; break;
+        case 'b': benchmark = true; break;
+        case 'v': verbose = true; break;
+        default:
+            fprintf(stderr, "usage: %s [-y first:last] [-s step] [-z zoneinfo] [-p] [-b] [-v]\n", argv[0]);
+            return 1;
+        }
+    if (step < 60)
+        step = 60;
+
+    if (nftw(zoneinfo, walk, 16, FTW_PHYS) != 0 || zones.empty())
+    {
+        fprintf(stderr, "%s: no zoneinfo\n", zoneinfo);
+        return 1;
+    }
+    std::sort(zones.begin(), zones.end());
+
+    // samples, utc
+    std::vector<time_t> samples;
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year = first - 1900;
+    tm.tm_mday = 1;
+    time_t from = timegm(&tm);
+    tm.tm_year = last + 1 - 1900;
+    time_t to = timegm(&tm);
+    for (time_t t = from; t <= to; t += step)
+        samples.push_back(t);
+
+    std::vector<time_t> random(100000);
+    uint64_t rng = 88172645463325252ULL;
+    for (time_t& t: random)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        t = from + (time_t)(rng % (uint64_t)(to - from));
+    }
+
+    std::set<std::string> seen;
+    int checked = 0, parser_bad = 0, stale = 0, slower = 0;
+    bench_result total = { 0, 0, 0, 0 };
+    for (const std::string& zone: zones)
+    {
+        const __FlashStringHelper* found = TZByName(zone.c_str());
+        if (!found)
+            continue;
+        seen.insert(tzh_name(zone));
+        std::string rule = (const char*)found;
+        checked++;
+
+        time_t at;
+        long lib, ref;
+        configTZByName(zone.c_str());
+        use_tz(rule.c_str());
+        if (!compare(samples, &at, &lib, &ref))
+        {
+            printf("%s: configTZ.cpp: '%s' at %s: TZToLocal() offset %ld, glibc %ld\n",
+                zone.c_str(), rule.c_str(), utc(at).c_str(), lib, ref);
+            parser_bad++;
+        }
+        else if (!parser_only)
+        {
+            use_tz((":" + std::string(zoneinfo) + "/" + zone).c_str());
+            if (!compare(samples, &at, &lib, &ref))
+            {
+                printf("%s: TZ.h '%s' differs from zoneinfo at %s: offset %ld, zoneinfo %ld\n",
+                    zone.c_str(), rule.c_str(), utc(at).c_str(), lib, ref);
+                stale++;
+            }
+        }
+
+        if (benchmark)
+        {
+            bench_result r = bench(zone.c_str(), rule.c_str(), random);
+            total.config_ns += r.config_ns;
+            total.seq_ns += r.seq_ns;
+            total.rnd_ns += r.rnd_ns;
+            total.glibc_ns += r.glibc_ns;
+            if (r.rnd_ns >= r.glibc_ns)
+            {
+                printf("%s: TZToLocal() %.1f ns, localtime_r() %.1f ns\n", zone.c_str(), r.rnd_ns, r.glibc_ns);
+                slower++;
+            }
+            if (verbose)
+                printf("%-32s configTZ %7.0f ns  TZToLocal %5.1f ns (sequential) %5.1f ns (random)  localtime_r %6.1f ns\n",
+                    zone.c_str(), r.config_ns, r.seq_ns, r.rnd_ns, r.glibc_ns);
+        }
+        else if (verbose)
+            printf("%s: ok\n", zone.c_str());
+    }
+
+    int missing = 0;
+    for (int i = 0; i < TZDB_ZONES; i++)
+        if (!seen.count(tzdb_names + tzdb_index[i][0]))
+        {
+            if (verbose)
+                printf("%s: not in %s, skipped\n", tzdb_names + tzdb_index[i][0], zoneinfo);
+            missing++;
+        }
+
+    printf("%d zones checked from %d to %d (%d TZ.h zones not in %s): %d configTZ.cpp errors, %d rules out of date\n",
+        checked, first, last, missing, zoneinfo, parser_bad, parser_only? 0: stale);
+    if (benchmark && checked)
+        printf("average per zone: configTZ %.0f ns, TZToLocal %.1f ns (sequential) %.1f ns (random), localtime_r %.1f ns%s\n",
+            total.config_ns / checked, total.seq_ns / checked, total.rnd_ns / checked, total.glibc_ns / checked,
+            slower? ", SLOWER": "");
+
+    return parser_bad || (!parser_only && stale) || slower? 1: 0;
+}
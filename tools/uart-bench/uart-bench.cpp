@@ -0,0 +1,353 @@
+/*
+ uart-bench: src/utility/uartbench.cpp (serial loopback benchmark) on a host
+
+ the loopback is a pty pair: what the benchmark writes on the slave side is
+ read on the master side, serialized at the baud rate (8N1, through a
+ UART_FIFO bytes fifo, so writes block like on the esp), optionally delayed,
+ dropped or corrupted, and written back.
+ a serial port with its RX and TX wired together can be used instead.
+
+ build (from the repository root):
+     g++ -O2 -Wall -Wextra -Isrc/utility tools/uart-bench/uart-bench.cpp \
+         src/utility/uartbench.cpp -o uart-bench
+ usage:
+     uart-bench [test]                   checks, exit status 1 on failure
+     uart-bench [link] pty               benchmark on the simulated line
+     uart-bench /dev/ttyXXX              benchmark on a looped back serial port
+     link: -d drop -c corrupt (probabilities, per byte) -l delay_us
+
+ released to the public domain
+*/
+
+#include <uartbench.h>
+
+#include <deque>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define UART_FIFO 128
+
+struct link_script
+{
+    double drop;
+    double corrupt;
+    uint32_t delay_us;
+};
+
+struct port
+{
+    int fd;                             // benchmark side
+    int master;                         // line side, -1 on a serial port
+    link_script script;
+    uint32_t baud;
+    double line_free_us;                // end of the last byte on the line
+    std::deque<std::pair<double, uint8_t>> line; // due time, byte
+    uint32_t yields;
+    uint32_t last_yield_us;
+    uint32_t max_gap_us;                // longest time without yield()
+};
+
+static uint32_t now_us ()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static double rnd ()
+{
+    return random() / (RAND_MAX + 1.0);
+}
+
+// moves bytes from the master side to the line, and back when they are due
+static void pump (port* p)
+{
+    if (p->master < 0)
+        return;
+    double now = now_us();
+    double byte_us = 10e6 / p->baud;
+
+    uint8_t buf[UART_FIFO];
+    size_t room = UART_FIFO - p->line.size();
+    ssize_t len = room? read(p->master, buf, room): 0;
+    for (ssize_t i = 0; i < len; i++)
+    {
+        p->line_free_us = (p->line_free_us > now? p->line_free_us: now) + byte_us;
+        if (rnd() < p->script.drop)
+            continue;
+        uint8_t c = buf[i];
+        if (rnd() < p->script.corrupt)
+            c ^= 1 << (random() % 8);
+        p->line.push_back({ p->line_free_us + p->script.delay_us, c });
+    }
+
+    while (!p->line.empty() && p->line.front().first <= now)
+    {
+        if (write(p->master, &p->line.front().second, 1) != 1)
+            break;
+        p->line.pop_front();
+    }
+}
+
+static speed_t tty_speed (uint32_t baud)
+{
+    switch (baud)
+    {
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1500000: return B1500000;
+    case 2000000: return B2000000;
+    case 3000000: return B3000000;
+    case 4000000: return B4000000;
+    default: return B0;
+    }
+}
+
+static bool port_set_baud (void* ctx, uint32_t baud)
+{
+    port* p = (port*)ctx;
+    struct termios tio;
+    speed_t speed = tty_speed(baud);
+    if (speed == B0 || tcgetattr(p->fd, &tio) != 0)
+        return false;
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, speed);
+    if (tcsetattr(p->fd, TCSANOW, &tio) != 0)
+        return false;
+    p->baud = baud;
+    return true;
+}
+
+static size_t port_write (void* ctx, const uint8_t* data, size_t len)
+{
+    port* p = (port*)ctx;
+    pump(p);
+    ssize_t n = write(p->fd, data, len);
+    return n > 0? n: 0;
+}
+
+static size_t port_read (void* ctx, uint8_t* data, size_t len)
+{
+    port* p = (port*)ctx;
+    pump(p);
+    ssize_t n = read(p->fd, data, len);
+    return n > 0? n: 0;
+}
+
+static uint32_t port_now_us (void*)
+{
+    return now_us();
+}
+
+static void port_yield (void* ctx)
+{
+    port* p = (port*)ctx;
+    uint32_t now = now_us();
+    if (p->yields++ && now - p->last_yield_us > p->max_gap_us)
+        p->max_gap_us = now - p->last_yield_us;
+    p->last_yield_us = now;
+    pump(p);
+}
+
+static const uart_bench_ops port_ops =
+{
+    port_set_baud,
+    port_write,
+    port_read,
+    port_now_us,
+    port_yield,
+};
+
+static bool open_pty (port* p, const link_script& script)
+{
+    p->master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (p->master < 0 || grantpt(p->master) || unlockpt(p->master))
+        return false;
+    p->fd = open(ptsname(p->master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    p->script = script;
+    p->line_free_us = 0;
+    p->line.clear();
+    p->yields = p->last_yield_us = p->max_gap_us = 0;
+    return p->fd >= 0;
+}
+
+static void close_port (port* p)
+{
+    close(p->fd);
+    if (p->master >= 0)
+        close(p->master);
+}
+
+static void print_results (const uart_bench_result* results, size_t count, int best)
+{
+    printf("    baud    bytes/s     sent     recv   errors  lat-min  lat-avg  lat-max lat-lost\n");
+    for (size_t i = 0; i < count; i++)
+    {
+        const uart_bench_result* r = &results[i];
+        if (!r->baud)
+            continue;
+        printf("%8u %10u %8u %8u %8u %8u %8u %8u %8u%s\n",
+            r->baud, r->bytes_per_s, r->sent, r->received, r->errors,
+            r->lat_min_us, r->lat_avg_us, r->lat_max_us, r->lat_lost,
+            (int)i == best? " <- fastest reliable": "");
+    }
+    if (best < 0)
+        printf("no reliable configuration\n");
+}
+
+// all UART_BENCH_BAUDS, like uart_loopback_bench()
+static int run_all (port* p, uart_bench_result* results, size_t count)
+{
+    static const uint32_t bauds [] = { UART_BENCH_BAUDS };
+    int best = -1;
+    for (size_t i = 0; i < count; i++)
+        if (!uart_bench_run(&port_ops, p, bauds[i], &results[i]))
+            results[i].baud = 0;
+        else if (uart_bench_reliable(&results[i]))
+            best = i;
+    return best;
+}
+
+/////////////////////
+// checks
+
+static int failed;
+
+#define CHECK(cond, ...) \
+    do { if (!(cond)) { failed++; printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+static bool run_one (const link_script& script, uint32_t baud, uart_bench_result* r, port* p)
+{
+    if (!open_pty(p, script))
+    {
+        printf("FAIL: no pty: %s\n", strerror(errno));
+        failed++;
+        return false;
+    }
+    bool ok = uart_bench_run(&port_ops, p, baud, r);
+    close_port(p);
+    CHECK(ok, "%u baud not set", baud);
+    return ok;
+}
+
+static void check_clean ()
+{
+    // every rate reliable, at the line rate, round-trip at least one byte time
+    static const uint32_t bauds [] = { UART_BENCH_BAUDS };
+    for (uint32_t baud: bauds)
+    {
+        uart_bench_result r;
+        port p;
+        if (!run_one(link_script { }, baud, &r, &p))
+            continue;
+        CHECK(uart_bench_reliable(&r), "%u: %u bytes/s, %u/%u, %u errors, %u lost",
+            baud, r.bytes_per_s, r.received, r.sent, r.errors, r.lat_lost);
+        CHECK(r.bytes_per_s <= baud / 10 + baud / 100, "%u: %u bytes/s above the line rate", baud, r.bytes_per_s);
+        CHECK(r.lat_min_us >= 10000000 / baud, "%u: %uus round-trip", baud, r.lat_min_us);
+        uint32_t hist = 0;
+        for (int i = 0; i < UART_BENCH_HIST; i++)
+            hist += r.lat_hist[i];
+        CHECK(hist == UART_BENCH_PINGS, "%u: %u latency samples", baud, hist);
+    }
+}
+
+static void check_faults ()
+{
+    uart_bench_result r;
+    port p;
+
+    // lost bytes: counted once each, not reliable
+    link_script drop = { };
+    drop.drop = 0.01;
+    if (run_one(drop, 921600, &r, &p))
+    {
+        CHECK(!uart_bench_reliable(&r), "reliable with drops");
+        CHECK(r.received < r.sent && r.errors >= (r.sent - r.received) / 2, "%u/%u, %u errors", r.received, r.sent, r.errors);
+    }
+
+    // corrupted bytes: balance kept, sequence breaks counted
+    link_script corrupt = { };
+    corrupt.corrupt = 0.01;
+    if (run_one(corrupt, 921600, &r, &p))
+    {
+        CHECK(!uart_bench_reliable(&r), "reliable with corruption");
+        CHECK(r.received == r.sent && r.errors, "%u/%u, %u errors", r.received, r.sent, r.errors);
+    }
+
+    // slow echo: measured, and yield() keeps being called while waiting
+    link_script slow = { };
+    slow.delay_us = UART_BENCH_TIMEOUT_US * 3 / 4;
+    if (run_one(slow, 115200, &r, &p))
+    {
+        CHECK(r.lat_min_us >= slow.delay_us && !r.lat_lost, "%uus, %u lost", r.lat_min_us, r.lat_lost);
+        CHECK(p.max_gap_us < slow.delay_us / 2, "%uus without yield()", p.max_gap_us);
+    }
+
+    // echo after the timeout: pings lost (or late, taken for the next one), run not stuck
+    slow.delay_us = UART_BENCH_TIMEOUT_US * 2;
+    if (run_one(slow, 921600, &r, &p))
+        CHECK(r.lat_lost && r.errors && !uart_bench_reliable(&r), "%u lost, %u errors", r.lat_lost, r.errors);
+}
+
+int main (int argc, char* argv[])
+{
+    link_script script = { };
+    int opt;
+    while ((opt = getopt(argc, argv, "d:c:l:")) != -1)
+        switch (opt)
+        {
+        case 'd': script.drop = atof(optarg); break;
+        case 'c': script.corrupt = atof(optarg); break;
+        case 'l': script.delay_us = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [test] | [-d drop] [-c corrupt] [-l delay_us] pty | /dev/ttyXXX\n", argv[0]);
+            return 1;
+        }
+    const char* mode = optind < argc? argv[optind]: "test";
+    srandom(1);
+
+    if (!strcmp(mode, "test"))
+    {
+        check_clean();
+        check_faults();
+        printf("uart-bench: %s\n", failed? "FAILED": "ok");
+        return failed? 1: 0;
+    }
+
+    port p;
+    if (!strcmp(mode, "pty"))
+    {
+        if (!open_pty(&p, script))
+        {
+            perror("pty");
+            return 1;
+        }
+    }
+    else
+    {
+        p.master = -1;
+        p.fd = open(mode, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (p.fd < 0)
+        {
+            perror(mode);
+            return 1;
+        }
+    }
+
+    static const uint32_t bauds [] = { UART_BENCH_BAUDS };
+    const size_t count = sizeof(bauds) / sizeof(bauds[0]);
+    uart_bench_result results[count];
+    int best = run_all(&p, results, count);
+    close_port(&p);
+    print_results(results, count, best);
+    return 0;
+}
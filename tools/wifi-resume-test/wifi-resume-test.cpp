@@ -0,0 +1,311 @@
+/*
+ wifi-resume-test: src/utility/wifiresume.cpp (wifi_on() fast resume) against
+ mock wifi_resume_ops, on a host
+
+ the RTC memory is a byte array, the clocks are virtual and the access point
+ is scripted (BSSID, channel, lease, time to connect on each path), so each
+ wake-up runs wifi_resume_poll() every WIFI_RESUME_POLL ms until it is done.
+
+ build (from the repository root):
+     g++ -O2 -Wall -Wextra -Isrc/utility tools/wifi-resume-test/wifi-resume-test.cpp \
+         src/utility/wifiresume.cpp -o wifi-resume-test
+ usage:
+     wifi-resume-test            exit status 1 on failure
+
+ released to the public domain
+*/
+
+#include <wifiresume.h>
+
+#include <stdio.h>
+#include <string.h>
+
+/////////////////////
+// mock
+
+static uint8_t rtc[sizeof(wifi_resume_state)];  // RTC memory at WIFI_RESUME_RTC_BLOCK
+static uint32_t now_ms;                 // since wake-up
+static uint32_t clock_s;                // survives deep sleep
+
+// the access point, as seen from the esp
+static struct
+{
+    uint8_t  bssid[6];
+    uint8_t  channel;
+    uint32_t ip;                        // address handed out by DHCP
+    uint32_t lease_s;
+    uint32_t fast_ms;                   // direct connection time, when the saved state matches
+    uint32_t full_ms;                   // scan + authentication + DHCP time
+} ap;
+
+static bool link_up;
+static uint32_t link_ms;                // now_ms when the link is up, 0: never
+static int fast_calls, full_calls;
+
+static bool mock_rtc_read (void* data, size_t len)
+{
+    if (len > sizeof(rtc))
+        return false;
+    memcpy(data, rtc, len);
+    return true;
+}
+
+static bool mock_rtc_write (const void* data, size_t len)
+{
+    if (len > sizeof(rtc))
+        return false;
+    memcpy(rtc, data, len);
+    return true;
+}
+
+static bool mock_get_link (wifi_resume_state* state)
+{
+    if (!link_up)
+        return false;
+    state->channel = ap.channel;
+    memcpy(state->bssid, ap.bssid, sizeof(state->bssid));
+    state->ip = ap.ip;
+    state->gw = 0x0100000a;
+    state->mask = 0x00ffffff;
+    state->dns = 0x0100000a;
+    state->lease_s = ap.lease_s;
+    return true;
+}
+
+static void mock_connect_fast (const wifi_resume_state* state)
+{
+    fast_calls++;
+    // stale BSSID, channel or address: the AP never answers
+    if (   state->channel == ap.channel
+        && !memcmp(state->bssid, ap.bssid, sizeof(ap.bssid))
+        && state->ip == ap.ip)
+        link_ms = now_ms + ap.fast_ms;
+}
+
+static void mock_connect_full ()
+{
+    full_calls++;
+    link_ms = now_ms + ap.full_ms;
+}
+
+static bool mock_connected ()
+{
+    if (link_ms && now_ms >= link_ms)
+        link_up = true;
+    return link_up;
+}
+
+static uint32_t mock_now_ms ()
+{
+    return now_ms;
+}
+
+static uint32_t mock_clock_s ()
+{
+    return clock_s;
+}
+
+static const wifi_resume_ops mock_ops =
+{
+    mock_rtc_read,
+    mock_rtc_write,
+    mock_get_link,
+    mock_connect_fast,
+    mock_connect_full,
+    mock_connected,
+    mock_now_ms,
+    mock_clock_s,
+};
+
+static wifi_resume resume;
+
+static void reset ()
+{
+    static const uint8_t bssid[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+    memset(rtc, 0, sizeof(rtc));
+    memcpy(ap.bssid, bssid, sizeof(bssid));
+    ap.channel = 6;
+    ap.ip = 0x0a00000a;
+    ap.lease_s = 3600;
+    ap.fast_ms = 150;
+    ap.full_ms = 2500;
+    clock_s = 1000;
+    resume = wifi_resume { &mock_ops, WIFI_RESUME_IDLE, 0, 0, false, 0, 0 };
+}
+
+// wifi_on(), until connected or given up
+static void wake ()
+{
+    now_ms = 0;
+    link_up = false;
+    link_ms = 0;
+    fast_calls = full_calls = 0;
+    wifi_resume_start(&resume);
+    while (wifi_resume_poll(&resume))
+        now_ms += WIFI_RESUME_POLL;
+    clock_s += now_ms / 1000;
+}
+
+// wifi_off() then deep sleep
+static void sleep_s (uint32_t s)
+{
+    wifi_resume_save(&resume);
+    link_up = false;
+    clock_s += s;
+}
+
+/////////////////////
+// checks
+
+static int failed;
+
+#define CHECK(cond, ...) \
+    do { if (!(cond)) { failed++; printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+static void check_fast ()
+{
+    // cold boot: nothing saved, full connection
+    reset();
+    wake();
+    CHECK(full_calls == 1 && !fast_calls, "fast %d full %d", fast_calls, full_calls);
+    CHECK(!resume.resumed && resume.connected_ms == ap.full_ms, "resumed %d in %ums", resume.resumed, resume.connected_ms);
+
+    // then every wake-up resumes with the saved state
+    for (int i = 0; i < 10; i++)
+    {
+        sleep_s(60);
+        wake();
+        CHECK(fast_calls == 1 && !full_calls, "wake %d: fast %d full %d", i, fast_calls, full_calls);
+        CHECK(resume.resumed && resume.connected_ms == ap.fast_ms, "wake %d: resumed %d in %ums", i, resume.resumed, resume.connected_ms);
+    }
+
+    // not connected when switched off: the previous state is kept
+    wifi_resume_save(&resume);
+    link_up = false;
+    sleep_s(60);
+    wake();
+    CHECK(resume.resumed, "state lost when saved while disconnected");
+}
+
+static void check_stale_bssid ()
+{
+    reset();
+    wake();
+    sleep_s(60);
+
+    // the AP was replaced while sleeping
+    ap.bssid[5] = 0x02;
+    wake();
+    CHECK(fast_calls == 1 && full_calls == 1, "fast %d full %d", fast_calls, full_calls);
+    CHECK(!resume.resumed && resume.connected_ms == WIFI_RESUME_TIMEOUT + ap.full_ms,
+        "resumed %d in %ums", resume.resumed, resume.connected_ms);
+
+    // the stale state was dropped at the fallback: no second timeout if the
+    // esp goes back to sleep before saving a new one
+    link_up = false;
+    clock_s += 60;
+    wake();
+    CHECK(!fast_calls && full_calls == 1, "stale state retried: fast %d full %d", fast_calls, full_calls);
+
+    // and the new AP is used from the next wake-up
+    sleep_s(60);
+    wake();
+    CHECK(resume.resumed && resume.connected_ms == ap.fast_ms, "resumed %d in %ums", resume.resumed, resume.connected_ms);
+
+    // AP never reachable: give up
+    sleep_s(60);
+    ap.full_ms = WIFI_RESUME_GIVEUP * 2;
+    ap.channel = 11;
+    wake();
+    CHECK(!link_up && !resume.connected_ms && now_ms == WIFI_RESUME_GIVEUP,
+        "link %d in %ums, gave up after %ums", link_up, resume.connected_ms, now_ms);
+}
+
+static void check_lease ()
+{
+    reset();
+    ap.lease_s = 600;
+    wake();
+
+    // still valid
+    sleep_s(600 - WIFI_RESUME_LEASE_MARGIN - 10);
+    wake();
+    CHECK(resume.resumed, "lease with %us left not used", WIFI_RESUME_LEASE_MARGIN + 10);
+
+    // within the margin: full connection, no fast path timeout
+    sleep_s(600 - WIFI_RESUME_LEASE_MARGIN + 1);
+    wake();
+    CHECK(!fast_calls && full_calls == 1 && resume.connected_ms == ap.full_ms,
+        "expired lease: fast %d full %d in %ums", fast_calls, full_calls, resume.connected_ms);
+
+    // expired long ago
+    sleep_s(24 * 3600);
+    wake();
+    CHECK(!fast_calls && full_calls == 1, "expired lease: fast %d full %d", fast_calls, full_calls);
+
+    // clock reset (power cycle without clearing RTC memory): lease unknown
+    sleep_s(10);
+    clock_s = 5;
+    wake();
+    CHECK(!fast_calls && full_calls == 1, "clock reset: fast %d full %d", fast_calls, full_calls);
+
+    // resumed cycles: the DHCP client is stopped and its counters frozen,
+    // the lease left reads the same on each save but still ends on time
+    ap.lease_s = 600;
+    wake();
+    int resumed = 0;
+    for (uint32_t t = 0; t < 600; t += 100)
+    {
+        sleep_s(100);
+        wake();
+        CHECK(resume.resumed == (t + 100 < 600 - WIFI_RESUME_LEASE_MARGIN),
+            "%us after DHCP: resumed %d", t + 100, resume.resumed);
+        resumed += resume.resumed;
+    }
+    CHECK(resumed == 5, "%d resumed wake-ups on a 600s lease", resumed);
+
+    // static address or infinite lease
+    ap.lease_s = 0xffffffff;
+    wake();
+    sleep_s(30 * 24 * 3600);
+    wake();
+    CHECK(resume.resumed, "infinite lease not used");
+}
+
+static void check_crc ()
+{
+    reset();
+    wake();
+    sleep_s(60);
+
+    // any change in RTC memory makes the state invalid
+    for (size_t i = 0; i < sizeof(wifi_resume_state); i++)
+        for (int b = 0; b < 8; b++)
+        {
+            uint8_t saved[sizeof(rtc)];
+            memcpy(saved, rtc, sizeof(rtc));
+            rtc[i] ^= 1 << b;
+            wake();
+            CHECK(!fast_calls && full_calls == 1, "byte %zu bit %d flipped: fast %d full %d", i, b, fast_calls, full_calls);
+            memcpy(rtc, saved, sizeof(rtc));
+        }
+
+    // power-up garbage and all zeros (invalidated)
+    memset(rtc, 0xa5, sizeof(rtc));
+    wake();
+    CHECK(!fast_calls && full_calls == 1, "garbage: fast %d full %d", fast_calls, full_calls);
+    memset(rtc, 0, sizeof(rtc));
+    wake();
+    CHECK(!fast_calls && full_calls == 1, "zeros: fast %d full %d", fast_calls, full_calls);
+}
+
+int main ()
+{
+    check_fast();
+    check_stale_bssid();
+    check_lease();
+    check_crc();
+
+    printf("wifi-resume-test: %s\n", failed? "FAILED": "ok");
+    return failed? 1: 0;
+}